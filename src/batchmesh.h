@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+
+#include "cellbatch.h"
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+//GPU side of a CellBatch, keeps a dynamic vertex buffer that is only reallocated when it has to grow
+class BatchMesh
+{
+public:
+	BatchMesh() = default;
+	BatchMesh(const BatchMesh&) = delete;
+	BatchMesh& operator=(const BatchMesh&) = delete;
+
+	~BatchMesh()
+	{
+		Unload();
+	}
+
+	int VertexCount() const
+	{
+		return mesh.vertexCount;
+	}
+
+	void Upload(const CellBatch& batch)
+	{
+		int count = batch.VertexCount();
+		if(count > capacity)
+		{
+			int newCapacity = std::max(count, capacity * 2);
+			Unload();
+			capacity = newCapacity;
+			//Colors need a non null buffer, otherwise raylib uses a constant vertex attribute instead of a vbo
+			std::vector<unsigned char> colors(capacity * 4, 0);
+			mesh = raylib::Mesh {};
+			mesh.vertexCount = capacity;
+			mesh.triangleCount = capacity / 3;
+			mesh.colors = colors.data();
+			raylib::UploadMesh(&mesh, true);
+			mesh.colors = nullptr;
+		}
+		if(count > 0)
+		{
+			raylib::UpdateMeshBuffer(mesh, 0, batch.Vertices(), count * 3 * sizeof(float), 0);
+			raylib::UpdateMeshBuffer(mesh, 3, batch.Colors(), count * 4 * sizeof(unsigned char), 0);
+		}
+		mesh.vertexCount = count;
+		mesh.triangleCount = count / 3;
+	}
+
+	//Draws all uploaded triangles with a single draw call
+	void Draw() const
+	{
+		if(mesh.vertexCount > 0)
+		{
+			raylib::DrawMesh(mesh, DefaultMaterial(), raylib::MatrixIdentity());
+		}
+	}
+
+	//Draws the vertices of batch as lines through the internal render batch of rlgl, which flushes only when it is full
+	static void DrawLines(const CellBatch& batch)
+	{
+		static const int linesPerBlock = 1024;
+		const float* v = batch.Vertices();
+		const unsigned char* c = batch.Colors();
+		int count = batch.VertexCount();
+		for(int from = 0; from < count; from += linesPerBlock * 2)
+		{
+			int to = std::min(from + linesPerBlock * 2, count);
+			raylib::rlCheckRenderBatchLimit(to - from);
+			raylib::rlBegin(RL_LINES);
+			for(int i = from; i < to; i++)
+			{
+				raylib::rlColor4ub(c[i * 4 + 0], c[i * 4 + 1], c[i * 4 + 2], c[i * 4 + 3]);
+				raylib::rlVertex3f(v[i * 3 + 0], v[i * 3 + 1], v[i * 3 + 2]);
+			}
+			raylib::rlEnd();
+		}
+	}
+
+private:
+	raylib::Mesh mesh = {};
+	int capacity = 0;
+
+	void Unload()
+	{
+		if(capacity > 0)
+		{
+			raylib::UnloadMesh(mesh);
+			mesh = raylib::Mesh {};
+			capacity = 0;
+		}
+	}
+
+	static const raylib::Material& DefaultMaterial()
+	{
+		static raylib::Material material = raylib::LoadMaterialDefault();
+		return material;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+#pragma once
+#include <type_traits>
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "grid3d.h"
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+//Paints or erases spheres of cells along a mouse stroke
+//The depth of a stroke is picked when it starts and kept while dragging, so painting does not grow towards the camera
+template<typename T>
+class Brush
+{
+	static_assert(std::is_base_of<Cell, T>::value, "T must derive from Cell");
+
+public:
+	//ray is in world coordinates, in which the grid is centered around the origin like in Renderer
+	//If start is true, a new stroke begins at the cell under the ray, otherwise the current stroke (if any) is continued
+	void Stroke(Grid3d<T>& grid, const raylib::Ray& ray, bool start, bool erase, float radius, const T& value)
+	{
+		const Extent& size = grid.GetSize();
+		raylib::Vector3 origin = raylib::Vector3Add(ray.position, raylib::Vector3 { size[0] * 0.5f, size[1] * 0.5f, size[2] * 0.5f });
+		raylib::Vector3 dir = raylib::Vector3Normalize(ray.direction);
+		if(start)
+		{
+			active = PickDistance(grid, origin, dir, erase, distance);
+			lastCenter[0] = lastCenter[1] = lastCenter[2] = -1;
+		}
+		if(!active)
+		{
+			return;
+		}
+
+		raylib::Vector3 p = raylib::Vector3Add(origin, raylib::Vector3Scale(dir, distance));
+		int center[3] =
+		{
+			std::clamp(static_cast<int>(std::floor(p.x)), 0, size[0] - 1),
+			std::clamp(static_cast<int>(std::floor(p.y)), 0, size[1] - 1),
+			std::clamp(static_cast<int>(std::floor(p.z)), 0, size[2] - 1)
+		};
+		if(std::equal(center, center + 3, lastCenter))
+		{
+			return;
+		}
+		std::copy(center, center + 3, lastCenter);
+		Paint(grid, center, radius, value);
+	}
+
+	void End()
+	{
+		active = false;
+	}
+
+	//Sets all cells within radius around center (a cell position) to value, only touching the cells inside the sphere
+	void Paint(Grid3d<T>& grid, const int center[3], float radius, const T& value)
+	{
+		const Extent& size = grid.GetSize();
+		const AxisWrap& wrap = grid.GetWrap();
+		int r = static_cast<int>(std::ceil(radius));
+		edits.clear();
+		for(int dz = -r; dz <= r; dz++)
+		{
+			for(int dy = -r; dy <= r; dy++)
+			{
+				for(int dx = -r; dx <= r; dx++)
+				{
+					if(dx * dx + dy * dy + dz * dz > radius * radius)
+					{
+						continue;
+					}
+					int c[3] = { center[0] + dx, center[1] + dy, center[2] + dz };
+					bool inside = true;
+					for(int a = 0; a < 3; a++)
+					{
+						if(wrap[a])
+						{
+							c[a] = ((c[a] % size[a]) + size[a]) % size[a];
+						}
+						inside &= c[a] >= 0 && c[a] < size[a];
+					}
+					if(inside)
+					{
+						edits.push_back(std::pair<int, T>(grid.GetIndex(c[0], c[1], c[2]), value));
+					}
+				}
+			}
+		}
+		if(edits.size() > 0)
+		{
+			grid.SetCells(edits);
+		}
+	}
+
+	//Steps through the grid cells along the ray with a 3d DDA (origin and dir in grid coordinates)
+	//Returns the first non empty cell in hit and the cell in front of it in before (the hit cell itself if the ray starts inside of it)
+	static bool Pick(const Grid3d<T>& grid, const raylib::Vector3& origin, const raylib::Vector3& dir, int hit[3], int before[3])
+	{
+		static const float inf = std::numeric_limits<float>::infinity();
+		const Extent& size = grid.GetSize();
+		float o[3] = { origin.x, origin.y, origin.z };
+		float d[3] = { dir.x, dir.y, dir.z };
+		float tEnter = 0.0f;
+		float tExit = inf;
+		if(!ClipToGrid(size, o, d, tEnter, tExit))
+		{
+			return false;
+		}
+
+		int c[3];
+		int step[3];
+		float tMax[3];
+		float tDelta[3];
+		for(int a = 0; a < 3; a++)
+		{
+			c[a] = std::clamp(static_cast<int>(std::floor(o[a] + d[a] * tEnter)), 0, size[a] - 1);
+			step[a] = d[a] > 0.0f ? 1 : -1;
+			tDelta[a] = d[a] != 0.0f ? std::abs(1.0f / d[a]) : inf;
+			tMax[a] = d[a] != 0.0f ? ((c[a] + (d[a] > 0.0f ? 1 : 0)) - o[a]) / d[a] : inf;
+		}
+		std::copy(c, c + 3, before);
+		while(true)
+		{
+			if(!grid.GetCell(c[0], c[1], c[2]).IsEmpty())
+			{
+				std::copy(c, c + 3, hit);
+				return true;
+			}
+			std::copy(c, c + 3, before);
+			int a = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+			if(tMax[a] > tExit)
+			{
+				return false;
+			}
+			c[a] += step[a];
+			tMax[a] += tDelta[a];
+			if(c[a] < 0 || c[a] >= size[a])
+			{
+				return false;
+			}
+		}
+	}
+
+private:
+	bool active = false;
+	float distance = 0.0f;
+	int lastCenter[3] = { -1, -1, -1 };
+	std::vector<std::pair<int, T>> edits;
+
+	//Intersects the ray with the bounds of the grid [0, size[0]] x [0, size[1]] x [0, size[2]]
+	static bool ClipToGrid(const Extent& size, const float o[3], const float d[3], float& tEnter, float& tExit)
+	{
+		for(int a = 0; a < 3; a++)
+		{
+			if(d[a] == 0.0f)
+			{
+				if(o[a] < 0.0f || o[a] > size[a])
+				{
+					return false;
+				}
+				continue;
+			}
+			float t0 = (0.0f - o[a]) / d[a];
+			float t1 = (size[a] - o[a]) / d[a];
+			tEnter = std::max(tEnter, std::min(t0, t1));
+			tExit = std::min(tExit, std::max(t0, t1));
+		}
+		return tEnter < tExit;
+	}
+
+	//Distance along the ray at which a stroke is painted
+	//Erasing starts at the first non empty cell, painting in front of it, if nothing is hit painting starts at the point closest to the center of the grid
+	static bool PickDistance(const Grid3d<T>& grid, const raylib::Vector3& origin, const raylib::Vector3& dir, bool erase, float& distance)
+	{
+		int hit[3];
+		int before[3];
+		if(Pick(grid, origin, dir, hit, before))
+		{
+			const int* c = erase ? hit : before;
+			raylib::Vector3 center = { c[0] + 0.5f, c[1] + 0.5f, c[2] + 0.5f };
+			distance = raylib::Vector3DotProduct(raylib::Vector3Subtract(center, origin), dir);
+			return true;
+		}
+		if(erase)
+		{
+			return false;
+		}
+
+		const Extent& size = grid.GetSize();
+		float o[3] = { origin.x, origin.y, origin.z };
+		float d[3] = { dir.x, dir.y, dir.z };
+		float tEnter = 0.0f;
+		float tExit = std::numeric_limits<float>::infinity();
+		if(!ClipToGrid(size, o, d, tEnter, tExit))
+		{
+			return false;
+		}
+		raylib::Vector3 gridCenter = { size[0] * 0.5f, size[1] * 0.5f, size[2] * 0.5f };
+		distance = std::clamp(raylib::Vector3DotProduct(raylib::Vector3Subtract(gridCenter, origin), dir), tEnter, tExit);
+		return true;
+	}
+};
\ No newline at end of file
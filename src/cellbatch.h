@@ -0,0 +1,137 @@
+#pragma once
+#include <vector>
+
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+//CPU side vertex buffer (positions + colors) for drawing many cells with a single draw call
+//Does not touch any graphics API, so it can be filled from worker threads
+class CellBatch
+{
+public:
+	static const int CUBE_VERTICES = 36;
+	static const int BILLBOARD_VERTICES = 6;
+	static const int CROSS_VERTICES = 6;
+
+	int VertexCount() const
+	{
+		return static_cast<int>(colors.size() / 4);
+	}
+
+	const float* Vertices() const
+	{
+		return vertices.data();
+	}
+
+	const unsigned char* Colors() const
+	{
+		return colors.data();
+	}
+
+	void Clear()
+	{
+		vertices.clear();
+		colors.clear();
+	}
+
+	//Resizes the buffer to vertexCount vertices, so that it can be filled in parallel with the Write* methods
+	void Resize(int vertexCount)
+	{
+		vertices.resize(vertexCount * 3);
+		colors.resize(vertexCount * 4);
+	}
+
+	void WriteVertex(int vertex, const raylib::Vector3& p, const raylib::Color& color)
+	{
+		float* v = &vertices[vertex * 3];
+		v[0] = p.x;
+		v[1] = p.y;
+		v[2] = p.z;
+		unsigned char* c = &colors[vertex * 4];
+		c[0] = color.r;
+		c[1] = color.g;
+		c[2] = color.b;
+		c[3] = color.a;
+	}
+
+	//Writes 2 triangles for the quad a, b, c, d (counter clockwise when viewed from the front)
+	void WriteQuad(int vertex, const raylib::Vector3& a, const raylib::Vector3& b, const raylib::Vector3& c, const raylib::Vector3& d, const raylib::Color& color)
+	{
+		WriteVertex(vertex + 0, a, color);
+		WriteVertex(vertex + 1, b, color);
+		WriteVertex(vertex + 2, c, color);
+		WriteVertex(vertex + 3, a, color);
+		WriteVertex(vertex + 4, c, color);
+		WriteVertex(vertex + 5, d, color);
+	}
+
+	//Writes CUBE_VERTICES vertices
+	void WriteCube(int vertex, const raylib::Vector3& center, float size, const raylib::Color& color)
+	{
+		float h = size * 0.5f;
+		for(int f = 0; f < 6; f++)
+		{
+			raylib::Vector3 p[4];
+			for(int i = 0; i < 4; i++)
+			{
+				const float* corner = CUBE_FACES[f][i];
+				p[i] = raylib::Vector3 { center.x + corner[0] * h, center.y + corner[1] * h, center.z + corner[2] * h };
+			}
+			WriteQuad(vertex + f * 6, p[0], p[1], p[2], p[3], color);
+		}
+	}
+
+	//Writes BILLBOARD_VERTICES vertices for a quad facing the camera, right and up are the camera axes
+	void WriteBillboard(int vertex, const raylib::Vector3& center, const raylib::Vector3& right, const raylib::Vector3& up, float size, const raylib::Color& color)
+	{
+		float h = size * 0.5f;
+		raylib::Vector3 r = { right.x * h, right.y * h, right.z * h };
+		raylib::Vector3 u = { up.x * h, up.y * h, up.z * h };
+		WriteQuad(vertex,
+			raylib::Vector3 { center.x - r.x - u.x, center.y - r.y - u.y, center.z - r.z - u.z },
+			raylib::Vector3 { center.x + r.x - u.x, center.y + r.y - u.y, center.z + r.z - u.z },
+			raylib::Vector3 { center.x + r.x + u.x, center.y + r.y + u.y, center.z + r.z + u.z },
+			raylib::Vector3 { center.x - r.x + u.x, center.y - r.y + u.y, center.z - r.z + u.z },
+			color);
+	}
+
+	//Writes CROSS_VERTICES vertices (3 axis aligned lines)
+	void WriteCross(int vertex, const raylib::Vector3& center, float size, const raylib::Color& color)
+	{
+		WriteVertex(vertex + 0, raylib::Vector3 { center.x - size, center.y, center.z }, color);
+		WriteVertex(vertex + 1, raylib::Vector3 { center.x + size, center.y, center.z }, color);
+		WriteVertex(vertex + 2, raylib::Vector3 { center.x, center.y - size, center.z }, color);
+		WriteVertex(vertex + 3, raylib::Vector3 { center.x, center.y + size, center.z }, color);
+		WriteVertex(vertex + 4, raylib::Vector3 { center.x, center.y, center.z - size }, color);
+		WriteVertex(vertex + 5, raylib::Vector3 { center.x, center.y, center.z + size }, color);
+	}
+
+	//Appends 2 triangles for the quad a, b, c, d (counter clockwise when viewed from the front)
+	void AppendQuad(const raylib::Vector3& a, const raylib::Vector3& b, const raylib::Vector3& c, const raylib::Vector3& d, const raylib::Color& color)
+	{
+		int vertex = VertexCount();
+		Resize(vertex + 6);
+		WriteQuad(vertex, a, b, c, d, color);
+	}
+
+	void Append(const CellBatch& other)
+	{
+		vertices.insert(vertices.end(), other.vertices.begin(), other.vertices.end());
+		colors.insert(colors.end(), other.colors.begin(), other.colors.end());
+	}
+
+private:
+	//Corners of each cube face in counter clockwise order when viewed from outside
+	static constexpr float CUBE_FACES[6][4][3] =
+	{
+		{ { 1, -1, -1 }, { 1, 1, -1 }, { 1, 1, 1 }, { 1, -1, 1 } },
+		{ { -1, -1, -1 }, { -1, -1, 1 }, { -1, 1, 1 }, { -1, 1, -1 } },
+		{ { -1, 1, -1 }, { -1, 1, 1 }, { 1, 1, 1 }, { 1, 1, -1 } },
+		{ { -1, -1, -1 }, { 1, -1, -1 }, { 1, -1, 1 }, { -1, -1, 1 } },
+		{ { -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 } },
+		{ { -1, -1, -1 }, { -1, 1, -1 }, { 1, 1, -1 }, { 1, -1, -1 } }
+	};
+
+	std::vector<float> vertices;
+	std::vector<unsigned char> colors;
+};
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <exception>
+
+#include "config.h"
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+//Color functions for the ColorMode settings, shared by all renderers
+namespace CellColor
+{
+	typedef raylib::Color (*ColorFunc)(const Extent& size, int x, int y, int z, float t, const std::vector<raylib::Color>& gradient);
+
+	static raylib::Color State(const Extent& size, int x, int y, int z, float t, const std::vector<raylib::Color>& gradient)
+	{
+		return gradient[static_cast<int>(std::floor(t * (gradient.size() - 1)))];
+	}
+
+	static raylib::Color XYZ(const Extent& size, int x, int y, int z, float t, const std::vector<raylib::Color>& gradient)
+	{
+		unsigned char r = static_cast<unsigned char>(std::floor(x / std::max(size[0] - 1.0f, 1.0f) * 255.0f));
+		unsigned char g = static_cast<unsigned char>(std::floor(y / std::max(size[1] - 1.0f, 1.0f) * 255.0f));
+		unsigned char b = static_cast<unsigned char>(std::floor(z / std::max(size[2] - 1.0f, 1.0f) * 255.0f));
+		return raylib::Color { r, g, b, 255 };
+	}
+
+	static raylib::Color Radius(const Extent& size, int x, int y, int z, float t, const std::vector<raylib::Color>& gradient)
+	{
+		static const float sqrt3 = std::sqrtf(3.0f);
+		//Distance along each axis relative to half of its size, so that the gradient reaches the sides of all axes
+		float dx = std::abs(x - size[0] * 0.5f) / (size[0] * 0.5f);
+		float dy = std::abs(y - size[1] * 0.5f) / (size[1] * 0.5f);
+		float dz = std::abs(z - size[2] * 0.5f) / (size[2] * 0.5f);
+		t = std::clamp((dx + dy + dz) / sqrt3, 0.0f, 1.0f);
+		return gradient[static_cast<int>(std::floor(t * (gradient.size() - 1)))];
+	}
+
+	//Color of a cluster (see Clusters), consecutive numbers are spread over the gradient with the golden ratio so that neighbouring clusters differ
+	static raylib::Color Cluster(int label, const std::vector<raylib::Color>& gradient)
+	{
+		float t = std::fmod(label * 0.618034f, 1.0f);
+		return gradient[static_cast<int>(std::floor(t * (gradient.size() - 1)))];
+	}
+
+	//Cluster colors depend on the whole grid, so renderers look them up with Cluster instead and only use the state for cells without a cluster
+	static ColorFunc Get(ColorMode colorMode)
+	{
+		switch(colorMode)
+		{
+			case ColorMode::State:
+				return &State;
+			case ColorMode::Xyz:
+				return &XYZ;
+			case ColorMode::Radius:
+				return &Radius;
+			case ColorMode::Cluster:
+				return &State;
+			default:
+				throw std::exception("Missing switch label in CellColor::Get!");
+		}
+	}
+}
\ No newline at end of file
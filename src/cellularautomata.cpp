@@ -3,6 +3,12 @@
 #include <random>
 #include <format>
 #include <chrono>
+#include <filesystem>
+#include <optional>
+#include <memory>
+#include <limits>
+#include <numeric>
+#include <thread>
 
 #define RAYGUI_IMPLEMENTATION
 #include "raylibinclude.h"
@@ -13,26 +19,130 @@
 #include "intcell.h"
 #include "gradient.h"
 #include "gradientpresets.h"
+#include "presets.h"
+#include "raycaster.h"
+#include "commandline.h"
+#include "frameexporter.h"
+#include "brush.h"
+#include "history.h"
+#include "simulation.h"
+#include "parallel.h"
+#include "mappedgrid.h"
+#include "gridallocator.h"
+#include "shard.h"
+#include "framebudget.h"
+#include "clusters.h"
+#include "perfcounters.h"
+#include "streamserver.h"
+#include "streamclient.h"
+#include "presetpreviews.h"
+#include "magic_enum.hpp"
 
-Grid3d<IntCell> grid(0, false, NeighbourMode::Moore);
-StaticSimSettings staticSettings;
+//One simulation shown in the window, with everything needed to display, edit and rewind it
+struct Instance
+{
+	Simulation simulation;
+	History<IntCell> history;
+	Renderer<IntCell> renderer;
+	Brush<IntCell> brush;
+	raylib::RenderTexture2D target = {};
+	//Reached the next generation while other instances are still stepping
+	bool stepDone = false;
+
+	Instance(const StaticSimSettings& settings, uint32_t seed) : simulation(settings, seed)
+	{
+		history.Reset(simulation.GetGrid());
+	}
+
+	~Instance()
+	{
+		if(target.id != 0)
+		{
+			raylib::UnloadRenderTexture(target);
+		}
+	}
+};
+
+std::vector<std::unique_ptr<Instance>> instances;
 DynamicSimSettings dynamicSettings;
 bool simulate = false;
 int steps = 0;
+//A step is spread over several frames, so the window stays responsive with large grids
+bool stepPending = false;
+FrameBudget stepBudget(SIM_FRAME_BUDGET_MS / 1000.0);
 std::vector<raylib::Color> gradient;
 
-float RandomF01();
-void Simulate();
+bool Advance();
+void CancelStep();
+void Seek(int generation);
 void Reset(StaticSimSettings settings);
 void SettingsChanged(DynamicSimSettings settings);
+void UpdateBrush(bool mouseOverUI);
+void RenderInstances();
+void UpdateHistory(UI& ui);
+bool SetupFromCommandLine(const CommandLine& cmd, RenderMode renderMode, StaticSimSettings& settings);
+DynamicSimSettings DynamicSettingsFromCommandLine(const CommandLine& cmd, RenderMode renderMode);
+int RunRaycast(const CommandLine& cmd);
+int RunExport(const CommandLine& cmd);
+int RunBenchmark(const CommandLine& cmd);
+int RunMapped(const CommandLine& cmd);
+int RunShards(const CommandLine& cmd);
+int RunShardWorker(const CommandLine& cmd);
+int RunServe(const CommandLine& cmd);
+int RunView(const CommandLine& cmd);
+int RunAnalyze(const CommandLine& cmd);
+int RunPreviews(const CommandLine& cmd);
+bool LargeSettingsFromCommandLine(const CommandLine& cmd, int defaultSize, StaticSimSettings& settings);
+AxisWrap WrapFromCommandLine(const CommandLine& cmd);
 
-int main()
+int main(int argc, char** argv)
 {
+	CommandLine cmd(argc, argv);
+	if(cmd.Has("raycast"))
+	{
+		return RunRaycast(cmd);
+	}
+	if(cmd.Has("export"))
+	{
+		return RunExport(cmd);
+	}
+	if(cmd.Has("benchmark"))
+	{
+		return RunBenchmark(cmd);
+	}
+	if(cmd.Has("mapped"))
+	{
+		return RunMapped(cmd);
+	}
+	if(cmd.Has("shard-worker"))
+	{
+		return RunShardWorker(cmd);
+	}
+	if(cmd.Has("shards"))
+	{
+		return RunShards(cmd);
+	}
+	if(cmd.Has("serve"))
+	{
+		return RunServe(cmd);
+	}
+	if(cmd.Has("view"))
+	{
+		return RunView(cmd);
+	}
+	if(cmd.Has("analyze"))
+	{
+		return RunAnalyze(cmd);
+	}
+	if(cmd.Has("previews"))
+	{
+		return RunPreviews(cmd);
+	}
+
 	raylib::InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Cellular Automata");
 	raylib::SetTargetFPS(RENDERER_FPS);
 
-	Renderer<IntCell> renderer = Renderer<IntCell>();
-	UI ui = UI(&Reset, &SettingsChanged, [](){ steps++; }, [](bool playing) { simulate = playing; });
+	UI ui = UI(&Reset, &SettingsChanged, [](){ steps++; }, [](bool playing) { simulate = playing; }, &Seek);
 
 	auto tPrev = std::chrono::high_resolution_clock::now();
 	double simSync = 0.0;
@@ -44,108 +154,879 @@ int main()
 		double dt = std::chrono::duration<double>(tCurr - tPrev).count();
 		tPrev = tCurr;
 		double targetSimSteps = 1.0 / dynamicSettings.stepsPerSecond;
-		if((simulate && ((simSync += dt) > targetSimSteps)) || steps > 0)
+		if(stepPending || (simulate && ((simSync += dt) > targetSimSteps)) || steps > 0)
 		{
-			if(simSync > targetSimSteps)
+			if(!stepPending)
 			{
-				simSync -= targetSimSteps;
+				if(simSync > targetSimSteps)
+				{
+					simSync -= targetSimSteps;
+				}
+				steps = std::clamp(steps - 1, 0, 100000);
 			}
-			steps = std::clamp(steps - 1, 0, 100000);
-			Simulate();
+			stepPending = !Advance();
 		}
-		renderer.Update();
+		instances[0]->renderer.Update();
+		UpdateBrush(ui.IsMouseOver());
+		UpdateHistory(ui);
 
 		//Rendering
 		raylib::BeginDrawing();
 		{
 			raylib::ClearBackground(raylib::Color { 30, 30, 30, 255 });
 
-			renderer.Render(grid, dynamicSettings, gradient);
+			RenderInstances();
 			ui.Update();
 		}
 		raylib::EndDrawing();
 	}
+	instances.clear();
 }
 
-float RandomF01()
+//Steps all instances forward at the same time, generations that are still in the history after stepping back are restored instead of simulated again
+//Only simulates as many planes as fit into the frame budget, returns true once all instances reached the next generation
+bool Advance()
 {
+	int planes = stepBudget.GetUnits(instances[0]->simulation.GetGrid().GetSize()[2]);
+	auto tStart = std::chrono::high_resolution_clock::now();
+	Parallel::For(0, static_cast<int>(instances.size()), [planes](int i)
+	{
+		Instance& instance = *instances[i];
+		if(instance.stepDone)
+		{
+			return;
+		}
+		if(instance.history.GetPosition() < instance.history.GetNewest())
+		{
+			instance.history.Restore(instance.history.GetPosition() + 1, instance.simulation.GetGrid());
+			instance.simulation.SetGeneration(instance.history.GetPosition());
+			instance.stepDone = true;
+			return;
+		}
+		if(instance.simulation.StepPart(planes))
+		{
+			instance.history.Record(instance.simulation.GetGrid());
+			instance.stepDone = true;
+		}
+	});
+	stepBudget.Record(planes, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count());
+
+	if(!std::all_of(instances.begin(), instances.end(), [](const std::unique_ptr<Instance>& instance) { return instance->stepDone; }))
+	{
+		return false;
+	}
+	CancelStep();
+	return true;
+}
+
+//Forgets a step that is spread over several frames, the instances discard their partial steps once the grids are modified
+void CancelStep()
+{
+	stepPending = false;
+	for(std::unique_ptr<Instance>& instance : instances)
+	{
+		instance->stepDone = false;
+	}
+}
+
+void Seek(int generation)
+{
+	CancelStep();
+	for(std::unique_ptr<Instance>& instance : instances)
+	{
+		instance->history.Restore(generation, instance->simulation.GetGrid());
+		instance->simulation.SetGeneration(instance->history.GetPosition());
+	}
+}
+
+//Creates settings.instances independent simulations with different seeds
+void Reset(StaticSimSettings settings)
+{
+	simulate = false;
+	stepPending = false;
 	static std::random_device rd;
-	static std::default_random_engine randEngine(rd());
-	static std::uniform_real_distribution<float> randDist = std::uniform_real_distribution<float>(0.0f, 1.0f);
-	return randDist(randEngine);
+	instances.clear();
+	for(int i = 0; i < std::max(settings.instances, 1); i++)
+	{
+		instances.push_back(std::make_unique<Instance>(settings, rd()));
+	}
+}
+
+void SettingsChanged(DynamicSimSettings settings)
+{
+	dynamicSettings = settings;
+	gradient = Gradient::Generate(Gradient::GetPreset(dynamicSettings.gradientPreset), GRADIENT_STEPS);
 }
 
-void Simulate()
+//Paints alive cells while the left and erases cells while the right mouse button is held, in the instance under the mouse
+//Edits replace all generations after the current one
+void UpdateBrush(bool mouseOverUI)
 {
-	grid.Transform([](const IntCell& cell, int neighbours)
+	int viewportWidth = raylib::GetScreenWidth() / static_cast<int>(instances.size());
+	raylib::Vector2 mouse = raylib::GetMousePosition();
+	int hovered = std::clamp(static_cast<int>(mouse.x) / viewportWidth, 0, static_cast<int>(instances.size()) - 1);
+
+	bool paint = raylib::IsMouseButtonDown(raylib::MouseButton::MOUSE_BUTTON_LEFT);
+	bool erase = raylib::IsMouseButtonDown(raylib::MouseButton::MOUSE_BUTTON_RIGHT);
+	//Strokes can only start outside of the UI, but may continue over it
+	bool start = raylib::IsMouseButtonPressed(raylib::MouseButton::MOUSE_BUTTON_LEFT) || raylib::IsMouseButtonPressed(raylib::MouseButton::MOUSE_BUTTON_RIGHT);
+	for(int i = 0; i < static_cast<int>(instances.size()); i++)
 	{
-		if(cell.IsAlive())
+		Instance& instance = *instances[i];
+		if(dynamicSettings.brushRadius <= 0.0f || paint == erase || (start && (mouseOverUI || i != hovered)))
 		{
-			if(staticSettings.surviveRule[neighbours] == false)
+			instance.brush.End();
+			continue;
+		}
+
+		Grid3d<IntCell>& grid = instance.simulation.GetGrid();
+		uint64_t revision = grid.GetRevision();
+		raylib::Ray ray = instance.renderer.GetRay(raylib::Vector2 { mouse.x - i * viewportWidth, mouse.y });
+		instance.brush.Stroke(grid, ray, start, erase, dynamicSettings.brushRadius, erase ? instance.simulation.EmptyCell() : instance.simulation.AliveCell());
+		if(grid.GetRevision() != revision)
+		{
+			instance.history.Truncate();
+		}
+	}
+}
+
+//Renders the instances side by side, each one into its own render texture if there are multiple
+void RenderInstances()
+{
+	int count = static_cast<int>(instances.size());
+	int width = raylib::GetScreenWidth() / count;
+	int height = raylib::GetScreenHeight();
+	const raylib::Camera& cam = instances[0]->renderer.GetCamera();
+	if(count == 1)
+	{
+		instances[0]->renderer.SetViewport(width, height);
+		instances[0]->renderer.Render(instances[0]->simulation.GetGrid(), dynamicSettings, gradient);
+		return;
+	}
+
+	for(int i = 0; i < count; i++)
+	{
+		Instance& instance = *instances[i];
+		if(instance.target.texture.width != width || instance.target.texture.height != height)
+		{
+			if(instance.target.id != 0)
 			{
-				return static_cast<IntCell>(cell - 1);
+				raylib::UnloadRenderTexture(instance.target);
 			}
-			return cell;
+			instance.target = raylib::LoadRenderTexture(width, height);
+		}
+		instance.renderer.SetCamera(cam);
+		instance.renderer.SetViewport(width, height);
+		raylib::BeginTextureMode(instance.target);
+		{
+			raylib::ClearBackground(raylib::Color { 30, 30, 30, 255 });
+			instance.renderer.Render(instance.simulation.GetGrid(), dynamicSettings, gradient);
+		}
+		raylib::EndTextureMode();
+	}
+	for(int i = 0; i < count; i++)
+	{
+		raylib::DrawTextureRec(instances[i]->target.texture, raylib::Rectangle { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(-height) }, raylib::Vector2 { static_cast<float>(i * width), 0.0f }, raylib::WHITE);
+		if(i > 0)
+		{
+			raylib::DrawLine(i * width, 0, i * width, height, raylib::Color { 245, 203, 66, 64 });
+		}
+	}
+}
+
+//All instances are stepped together, so the common range of their histories is shown
+void UpdateHistory(UI& ui)
+{
+	int oldest = 0;
+	int newest = std::numeric_limits<int>::max();
+	size_t bytes = 0;
+	for(const std::unique_ptr<Instance>& instance : instances)
+	{
+		oldest = std::max(oldest, instance->history.GetOldest());
+		newest = std::min(newest, instance->history.GetNewest());
+		bytes += instance->history.GetBytes();
+	}
+	ui.SetHistory(oldest, newest, instances[0]->history.GetPosition(), bytes);
+}
+
+//Reads the preset and settings given on the command line (--preset, --size <n or XxYxZ>, --wrap <axes>, --no-wrap, --async <update prob>, --render-mode, --color-mode, --gradient)
+bool SetupFromCommandLine(const CommandLine& cmd, RenderMode renderMode, StaticSimSettings& settings)
+{
+	const Preset* preset = FindPreset(cmd.Get("preset", START_PRESET.name));
+	if(preset == nullptr)
+	{
+		std::cerr << std::format("Unknown preset \"{0}\"", cmd.Get("preset")) << std::endl;
+		return false;
+	}
+
+	std::optional<Extent> extent = cmd.GetExtent("size", 50);
+	if(!extent.has_value())
+	{
+		std::cerr << std::format("Invalid size \"{0}\", expected n or XxYxZ", cmd.Get("size")) << std::endl;
+		return false;
+	}
+	Extent size = extent.value();
+	AxisWrap wrap = WrapFromCommandLine(cmd);
+	for(int a = 0; a < 3; a++)
+	{
+		size[a] = std::clamp(size[a], wrap[a] ? SIM_MIN_WRAP_DIM_SIZE : 1, SIM_MAX_DIM_SIZE);
+	}
+	settings = preset->ToSettings(size, wrap);
+	if(cmd.Has("async"))
+	{
+		settings.updateMode = UpdateMode::Asynchronous;
+		settings.updateProb = cmd.Get("async").empty() ? settings.updateProb : std::clamp(cmd.GetFloat("async", settings.updateProb), 0.01f, 1.0f);
+	}
+	SettingsChanged(DynamicSettingsFromCommandLine(cmd, renderMode));
+	return true;
+}
+
+//Axes along which the cells wrap around, all by default, none with --no-wrap and only the given ones with --wrap, e.g. --wrap xy
+AxisWrap WrapFromCommandLine(const CommandLine& cmd)
+{
+	if(cmd.Has("no-wrap"))
+	{
+		return AxisWrap { false, false, false };
+	}
+	if(!cmd.Has("wrap"))
+	{
+		return AxisWrap { true, true, true };
+	}
+	std::string axes = cmd.Get("wrap");
+	return AxisWrap { axes.find('x') != std::string::npos, axes.find('y') != std::string::npos, axes.find('z') != std::string::npos };
+}
+
+//Reads the display settings given on the command line (--render-mode, --color-mode, --gradient)
+DynamicSimSettings DynamicSettingsFromCommandLine(const CommandLine& cmd, RenderMode renderMode)
+{
+	return DynamicSimSettings
+	{
+		.renderMode = magic_enum::enum_cast<RenderMode>(cmd.Get("render-mode", "")).value_or(renderMode),
+		.colorMode = magic_enum::enum_cast<ColorMode>(cmd.Get("color-mode", "Radius")).value_or(ColorMode::Radius),
+		.gradientPreset = magic_enum::enum_cast<GradientPreset>(cmd.Get("gradient", "Random_3")).value_or(GradientPreset::Random_3),
+		.stepsPerSecond = 0.0f
+	};
+}
+
+//Simulates a preset without a window and writes a CPU raycasted image every few steps
+//--raycast --preset <name> --size <n> --seed <n> --steps <n> --every <n> --width <n> --height <n> --orbit <degrees per image> --color-mode <mode> --gradient <preset> --out <dir>
+int RunRaycast(const CommandLine& cmd)
+{
+	StaticSimSettings settings;
+	if(!SetupFromCommandLine(cmd, RenderMode::Cube, settings))
+	{
+		return 1;
+	}
+	Simulation simulation(settings, static_cast<uint32_t>(cmd.GetInt("seed", static_cast<int>(std::random_device()()))));
+	const Extent& size = simulation.GetGrid().GetSize();
+	int stepCount = cmd.GetInt("steps", 100);
+	int every = std::max(cmd.GetInt("every", 1), 1);
+	int width = cmd.GetInt("width", static_cast<int>(WINDOW_WIDTH));
+	int height = cmd.GetInt("height", static_cast<int>(WINDOW_HEIGHT));
+	float orbit = cmd.GetFloat("orbit", 1.0f);
+	std::filesystem::path outDir = cmd.Get("out", "frames");
+	std::filesystem::create_directories(outDir);
+
+	Raycaster<IntCell> raycaster;
+	std::vector<raylib::Color> pixels;
+	raylib::Camera cam = {};
+	cam.target = raylib::Vector3 { 0.0f, 0.0f, 0.0f };
+	cam.up = raylib::Vector3 { 0.0f, 1.0f, 0.0f };
+	cam.fovy = RENDERER_FOV;
+	float camDistance = std::max({ size[0], size[1], size[2] }) * 1.6f;
+
+	//The steps between two images are not needed, so they are simulated at once
+	for(int step = 0, image = 0; step <= stepCount; step += every)
+	{
+		auto tStart = std::chrono::high_resolution_clock::now();
+		float angle = image * orbit * DEG2RAD;
+		cam.position = raylib::Vector3 { std::cos(angle) * camDistance, camDistance * 0.6f, std::sin(angle) * camDistance };
+		raycaster.Update(simulation.GetGrid(), dynamicSettings.colorMode, gradient);
+		raycaster.Render(cam, width, height, pixels);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+		std::filesystem::path file = outDir / std::format("frame_{:05}.png", image++);
+		raylib::ExportImage(raylib::Image { pixels.data(), width, height, 1, raylib::PixelFormat::PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 }, file.string().c_str());
+		std::cout << std::format("Step {0}: {1} ({2:.1f} ms)", step, file.string(), ms) << std::endl;
+		if(step + every <= stepCount)
+		{
+			simulation.Step(every);
+		}
+	}
+	return 0;
+}
+
+//Simulates a preset with the regular renderer and streams every frame to a FrameExporter
+//Only the pixel readback happens on the main thread, the conversion, encoding and writing of the frames runs on worker threads
+//--export <png|y4m> --preset <name> --size <n> --seed <n> --frames <n> --every <n> --width <n> --height <n> --fps <n> --render-mode <mode> --color-mode <mode> --gradient <preset> --out <dir|file|->
+int RunExport(const CommandLine& cmd)
+{
+	std::optional<ExportFormat> format = magic_enum::enum_cast<ExportFormat>(cmd.Get("export", "Png"), magic_enum::case_insensitive);
+	if(!format.has_value())
+	{
+		std::cerr << std::format("Unknown export format \"{0}\"", cmd.Get("export")) << std::endl;
+		return 1;
+	}
+	StaticSimSettings settings;
+	if(!SetupFromCommandLine(cmd, RenderMode::Cube, settings))
+	{
+		return 1;
+	}
+	Simulation simulation(settings, static_cast<uint32_t>(cmd.GetInt("seed", static_cast<int>(std::random_device()()))));
+
+	int frameCount = cmd.GetInt("frames", 300);
+	int every = std::max(cmd.GetInt("every", 1), 1);
+	int width = cmd.GetInt("width", static_cast<int>(WINDOW_WIDTH));
+	int height = cmd.GetInt("height", static_cast<int>(WINDOW_HEIGHT));
+	int fps = std::max(cmd.GetInt("fps", 30), 1);
+	std::string out = cmd.Get("out", format == ExportFormat::Png ? "frames" : "frames.y4m");
+
+	//Frames are rendered as fast as possible, the window only shows a preview
+	raylib::SetTraceLogLevel(out == "-" ? raylib::TraceLogLevel::LOG_NONE : raylib::TraceLogLevel::LOG_WARNING);
+	raylib::InitWindow(width, height, "Cellular Automata - Export");
+	raylib::RenderTexture2D target = raylib::LoadRenderTexture(width, height);
+
+	Renderer<IntCell> renderer = Renderer<IntCell>();
+	FrameExporter exporter(format.value(), out, width, height, fps, std::max(Parallel::ThreadCount() - 1, 1), EXPORT_QUEUE_SIZE);
+
+	auto tStart = std::chrono::high_resolution_clock::now();
+	for(int frame = 0; frame < frameCount && !raylib::WindowShouldClose() && !exporter.Failed(); frame++)
+	{
+		renderer.Update();
+		raylib::BeginTextureMode(target);
+		{
+			raylib::ClearBackground(raylib::Color { 30, 30, 30, 255 });
+			renderer.Render(simulation.GetGrid(), dynamicSettings, gradient);
+		}
+		raylib::EndTextureMode();
+		exporter.Push(raylib::LoadImageFromTexture(target.texture));
+
+		raylib::BeginDrawing();
+		{
+			raylib::DrawTextureRec(target.texture, raylib::Rectangle { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(-height) }, raylib::Vector2 { 0.0f, 0.0f }, raylib::WHITE);
+			raylib::DrawText(std::format("Frame {0}/{1}", frame + 1, frameCount).c_str(), 10, 10, 20, raylib::RAYWHITE);
+		}
+		raylib::EndDrawing();
+
+		simulation.Step(every);
+	}
+	exporter.Finish();
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+	raylib::UnloadRenderTexture(target);
+	raylib::CloseWindow();
+	if(out != "-")
+	{
+		std::cout << std::format("Exported {0} frames to {1} ({2:.1f} frames/s)", exporter.FramesWritten(), out, exporter.FramesWritten() / seconds) << std::endl;
+	}
+	return exporter.Failed() ? 1 : 0;
+}
+
+//Measures the simulation speed with single steps, with temporally blocked steps and (for symmetric fills) on the symmetric domain of the same preset and seed and checks that all give the same cells
+//Hardware counters of each variant are reported per cell and per step if they are available
+//--benchmark --preset <name> --size <n> --seed <n> --steps <n> --block <generations per pass> --slab <planes per slab> --no-huge-pages --no-first-touch --no-symmetry --no-counters
+int RunBenchmark(const CommandLine& cmd)
+{
+	StaticSimSettings settings;
+	if(!SetupFromCommandLine(cmd, RenderMode::Cube, settings))
+	{
+		return 1;
+	}
+	uint32_t seed = static_cast<uint32_t>(cmd.GetInt("seed", static_cast<int>(std::random_device()())));
+	int stepCount = std::max(cmd.GetInt("steps", 64), 1);
+	int block = std::clamp(cmd.GetInt("block", 4), 1, stepCount);
+	int slab = std::max(cmd.GetInt("slab", GRID_BLOCK_SLAB_SIZE), 1);
+	stepCount -= stepCount % block;
+	GridMemory::GetOptions().hugePages = !cmd.Has("no-huge-pages");
+	GridMemory::GetOptions().firstTouch = !cmd.Has("no-first-touch");
+
+	bool symmetric = !cmd.Has("no-symmetry");
+	settings.engine = StepEngine::Dense;
+	Simulation single(settings, seed);
+	Simulation blocked(settings, seed);
+	double cells = static_cast<double>(single.GetGrid().GetCellCount());
+	PerfCounters counters;
+	bool countersOpen = !cmd.Has("no-counters") && counters.Open();
+
+	counters.Start();
+	auto tStart = std::chrono::high_resolution_clock::now();
+	for(int i = 0; i < stepCount; i++)
+	{
+		single.Step();
+	}
+	double singleSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+	PerfCounters::Sample singleCounts = counters.Stop();
+
+	counters.Start();
+	tStart = std::chrono::high_resolution_clock::now();
+	for(int i = 0; i < stepCount; i += block)
+	{
+		blocked.Step(block, slab);
+	}
+	double blockedSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+	PerfCounters::Sample blockedCounts = counters.Stop();
+
+	//Only if the preset and size give a symmetric fill
+	std::unique_ptr<Simulation> reduced;
+	double reducedSeconds = 0.0;
+	PerfCounters::Sample reducedCounts = {};
+	settings.engine = StepEngine::Symmetric;
+	if(symmetric && SymmetricGrid::Detect(Simulation(settings, seed).GetGrid()).GetOrder() > 1)
+	{
+		reduced = std::make_unique<Simulation>(settings, seed);
+		counters.Start();
+		tStart = std::chrono::high_resolution_clock::now();
+		for(int i = 0; i < stepCount; i += block)
+		{
+			reduced->Step(block);
+			//The full grid is only expanded when it is read, which every consumer does after stepping
+			reduced->GetGrid();
+		}
+		reducedSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+		reducedCounts = counters.Stop();
+	}
+
+	//Single steps with the engine that is picked for the current cells
+	settings.engine = StepEngine::Auto;
+	Simulation automatic(settings, seed);
+	counters.Start();
+	tStart = std::chrono::high_resolution_clock::now();
+	for(int i = 0; i < stepCount; i++)
+	{
+		automatic.Step();
+	}
+	double autoSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+	PerfCounters::Sample autoCounts = counters.Stop();
+
+	//Counts per cell of the full grid and per step, so that the variants can be compared directly
+	auto printCounts = [&](const PerfCounters::Sample& counts)
+	{
+		if(!countersOpen)
+		{
+			return;
 		}
-		else if(cell.IsEmpty())
+		std::string perCell;
+		std::string perStep;
+		for(int c = 0; c < PerfCounters::Count; c++)
 		{
-			if(staticSettings.spawnRule[neighbours])
+			const char* name = PerfCounters::GetName(static_cast<PerfCounters::Counter>(c));
+			std::string separator = c > 0 ? ", " : "";
+			if(counts[c] < 0)
 			{
-				return IntCell(staticSettings.states - 1);
+				perCell += std::format("{0}{1} n/a", separator, name);
+				perStep += std::format("{0}{1} n/a", separator, name);
+				continue;
+			}
+			perCell += std::format("{0}{1:.3f} {2}", separator, counts[c] / (cells * stepCount), name);
+			perStep += std::format("{0}{1:.2f}M {2}", separator, counts[c] / 1e6 / stepCount, name);
+			if(c == PerfCounters::Instructions && counts[PerfCounters::Cycles] > 0)
+			{
+				perCell += std::format(" (IPC {0:.2f})", counts[c] / static_cast<double>(counts[PerfCounters::Cycles]));
 			}
-			return cell;
 		}
-		return static_cast<IntCell>(cell - 1);
-	});
+		std::cout << "  Per cell: " << perCell << std::endl;
+		std::cout << "  Per step: " << perStep << std::endl;
+	};
+
+	int mismatches = 0;
+	for(int i = 0; i < static_cast<int>(cells); i++)
+	{
+		mismatches += static_cast<int>(single.GetGrid()[i]) != static_cast<int>(blocked.GetGrid()[i]) ? 1 : 0;
+		mismatches += reduced != nullptr && static_cast<int>(single.GetGrid()[i]) != static_cast<int>(reduced->GetGrid()[i]) ? 1 : 0;
+		mismatches += static_cast<int>(single.GetGrid()[i]) != static_cast<int>(automatic.GetGrid()[i]) ? 1 : 0;
+	}
+
+	std::cout << std::format("{0}x{1}x{2} cells, {3} steps, {4} threads", settings.size[0], settings.size[1], settings.size[2], stepCount, Parallel::ThreadCount()) << std::endl;
+	if(!countersOpen && !cmd.Has("no-counters"))
+	{
+		std::cout << counters.GetError() << ", only timings are reported" << std::endl;
+	}
+	std::cout << std::format("Single:  {0:.3f} ms/step, {1:.1f} Mcells/s", singleSeconds * 1000.0 / stepCount, cells * stepCount / singleSeconds / 1e6) << std::endl;
+	printCounts(singleCounts);
+	std::cout << std::format("Blocked: {0:.3f} ms/step, {1:.1f} Mcells/s ({2} steps per pass, {3} planes per slab)", blockedSeconds * 1000.0 / stepCount, cells * stepCount / blockedSeconds / 1e6, block, slab) << std::endl;
+	printCounts(blockedCounts);
+	if(reduced != nullptr)
+	{
+		std::cout << std::format("Symmetric: {0:.3f} ms/step, {1:.1f} Mcells/s ({2} symmetric copies)", reducedSeconds * 1000.0 / stepCount, cells * stepCount / reducedSeconds / 1e6, reduced->GetSymmetryOrder()) << std::endl;
+		printCounts(reducedCounts);
+	}
+	std::string engines;
+	for(StepEngine engine : { StepEngine::Dense, StepEngine::Active, StepEngine::Symmetric })
+	{
+		engines += std::format("{0}{1} {2}", engines.empty() ? "" : ", ", magic_enum::enum_name(engine), automatic.GetEngineSteps(engine));
+	}
+	std::cout << std::format("Auto:    {0:.3f} ms/step, {1:.1f} Mcells/s (steps per engine: {2})", autoSeconds * 1000.0 / stepCount, cells * stepCount / autoSeconds / 1e6, engines) << std::endl;
+	printCounts(autoCounts);
+	std::cout << (mismatches == 0 ? std::string("Results match") : std::format("{0} cells differ!", mismatches)) << std::endl;
+
+	//Placement of the grid buffers
+	GridMemory::Stats& memory = GridMemory::GetStats();
+	int64_t hugePageBytes = GridMemory::HugePageBytesInUse();
+	std::cout << std::format("Memory:  {0:.1f} MB in {1} grid buffers, first touched by {2} threads, huge pages {3}", memory.bytes / (1024.0 * 1024.0), memory.buffers.load(), memory.touchThreads.load(),
+		!GridMemory::GetOptions().hugePages ? std::string("off") : (hugePageBytes >= 0 ? std::format("requested ({0:.1f} MB in use)", hugePageBytes / (1024.0 * 1024.0)) : std::string("requested"))) << std::endl;
+	std::vector<int> nodes = GridMemory::PagesPerNode(&single.GetGrid()[0], static_cast<size_t>(cells) * sizeof(IntCell));
+	std::string placement;
+	int sampled = std::accumulate(nodes.begin(), nodes.end(), 0);
+	for(int node = 0; node < static_cast<int>(nodes.size()); node++)
+	{
+		placement += std::format(" node {0}: {1:.0f}%", node, 100.0 * nodes[node] / std::max(sampled, 1));
+	}
+	std::cout << "Pages:  " << (nodes.empty() ? std::string(" NUMA placement unknown") : placement) << std::endl;
+	return mismatches == 0 ? 0 : 1;
 }
 
-void Reset(StaticSimSettings settings)
+//Simulates a grid that is stored in a memory mapped file instead of memory, so that it can be larger than the available memory
+//The file is created from the preset if it does not exist or --size is given, otherwise the simulation continues from the generation stored in it
+//--mapped <file> --preset <name> --size <n> --seed <n> --steps <n> --no-wrap
+int RunMapped(const CommandLine& cmd)
 {
-	staticSettings = settings;
-	IntCell::statesMinusOne = settings.states - 1;
-	grid = Grid3d<IntCell>(settings.dimSize, settings.wrapSide, staticSettings.neighbourMode);
-	simulate = false;
+	std::string path = cmd.Get("mapped", "grid.ca3d");
+	MappedGrid grid;
+	if(cmd.Has("size") || !std::filesystem::exists(path))
+	{
+		StaticSimSettings settings;
+		if(!LargeSettingsFromCommandLine(cmd, 256, settings))
+		{
+			return 1;
+		}
+		if(!grid.Create(path, settings, static_cast<uint32_t>(cmd.GetInt("seed", static_cast<int>(std::random_device()())))))
+		{
+			std::cerr << grid.GetError() << std::endl;
+			return 1;
+		}
+	}
+	else if(!grid.Open(path))
+	{
+		std::cerr << grid.GetError() << std::endl;
+		return 1;
+	}
+
+	int stepCount = std::max(cmd.GetInt("steps", 10), 0);
+	double cells = static_cast<double>(grid.GetCellCount());
+	std::cout << std::format("{0}^3 cells in \"{1}\", generation {2}, population {3}, {4:.1f} MB resident while stepping", grid.GetDimSize(), path, grid.GetGeneration(), grid.GetPopulation(), grid.GetWindowBytes() / (1024.0 * 1024.0)) << std::endl;
+	for(int i = 0; i < stepCount; i++)
+	{
+		auto tStart = std::chrono::high_resolution_clock::now();
+		grid.Step();
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+		std::cout << std::format("Generation {0}: population {1}, alive {2}, changed {3}, {4:.1f} Mcells/s", grid.GetGeneration(), grid.GetPopulation(), grid.GetAliveCount(), grid.GetChangedCount(), cells / seconds / 1e6) << std::endl;
+	}
+	grid.Flush();
+	return 0;
+}
 
-	raylib::Vector3 center = { settings.dimSize * 0.5f - 0.01f, settings.dimSize * 0.5f - 0.01f, settings.dimSize * 0.5f - 0.01f };
-	float d = settings.fillDiameter;
+//Settings of a preset for the modes that do not keep the grid in the memory of one process, which allow larger sizes than the window
+bool LargeSettingsFromCommandLine(const CommandLine& cmd, int defaultSize, StaticSimSettings& settings)
+{
+	const Preset* preset = FindPreset(cmd.Get("preset", START_PRESET.name));
+	if(preset == nullptr)
+	{
+		std::cerr << std::format("Unknown preset \"{0}\"", cmd.Get("preset")) << std::endl;
+		return false;
+	}
+	//The mapped and sharded grids are cubes that wrap around along all axes or none
+	int size = std::clamp(cmd.GetInt("size", defaultSize), 5, MAPPED_MAX_DIM_SIZE);
+	AxisWrap wrap;
+	wrap.fill(!cmd.Has("no-wrap"));
+	settings = preset->ToSettings({ size, size, size }, wrap);
+	return true;
+}
 
-	bool (*selectFunc)(raylib::Vector3 p, raylib::Vector3 center, float radius) = nullptr;
-	switch(settings.fillShape)
+//Splits the grid along z into shards that are simulated by worker processes, which exchange the planes at their borders through shared memory
+//--verify compares the result with a Simulation in this process, --snapshot writes the final cells to a file that can be continued with --mapped
+//--shards <n> --preset <name> --size <n> --seed <n> --steps <n> --no-wrap --verify --snapshot <file>
+int RunShards(const CommandLine& cmd)
+{
+	StaticSimSettings settings;
+	if(!LargeSettingsFromCommandLine(cmd, 128, settings))
 	{
-		case FillShape::Cube:
-			selectFunc = [](raylib::Vector3 p, raylib::Vector3 center, float diameter)
+		return 1;
+	}
+	uint32_t seed = static_cast<uint32_t>(cmd.GetInt("seed", static_cast<int>(std::random_device()())));
+	int shardCount = std::clamp(cmd.GetInt("shards", 2), 1, std::min(SHARD_MAX_COUNT, settings.size[0]));
+	int stepCount = std::max(cmd.GetInt("steps", 10), 0);
+	bool verify = cmd.Has("verify");
+
+	ShardCoordinator coordinator;
+	std::vector<uint8_t> initial;
+	if(!coordinator.Start(cmd.GetProgram(), settings, seed, shardCount) || (verify && !coordinator.Snapshot(initial)))
+	{
+		std::cerr << coordinator.GetError() << std::endl;
+		return 1;
+	}
+
+	double cells = static_cast<double>(settings.size[0]) * settings.size[1] * settings.size[2];
+	std::cout << std::format("{0}^3 cells in {1} shards", settings.size[0], shardCount) << std::endl;
+	for(int i = 0; i < stepCount; i++)
+	{
+		auto tStart = std::chrono::high_resolution_clock::now();
+		if(!coordinator.Step(1))
+		{
+			std::cerr << coordinator.GetError() << std::endl;
+			return 1;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+		PlaneKernel::Stats stats = coordinator.GetStats();
+		std::cout << std::format("Generation {0}: population {1}, alive {2}, changed {3}, {4:.1f} Mcells/s", coordinator.GetGeneration(), stats.population, stats.alive, stats.changed, cells / seconds / 1e6) << std::endl;
+	}
+
+	std::vector<uint8_t> result;
+	if((verify || cmd.Has("snapshot")) && !coordinator.Snapshot(result))
+	{
+		std::cerr << coordinator.GetError() << std::endl;
+		return 1;
+	}
+	coordinator.Stop();
+
+	int mismatches = 0;
+	if(verify)
+	{
+		Simulation simulation(settings, seed);
+		std::vector<IntCell> loaded;
+		loaded.reserve(initial.size());
+		for(uint8_t state : initial)
+		{
+			loaded.push_back(simulation.EmptyCell().WithValue(state));
+		}
+		simulation.GetGrid().Load(loaded);
+		for(int i = 0; i < stepCount; i++)
+		{
+			simulation.Step();
+		}
+		for(int i = 0; i < static_cast<int>(result.size()); i++)
+		{
+			mismatches += static_cast<int>(simulation.GetGrid()[i]) != result[i] ? 1 : 0;
+		}
+		std::cout << (mismatches == 0 ? std::string("Results match") : std::format("{0} cells differ!", mismatches)) << std::endl;
+	}
+	if(cmd.Has("snapshot"))
+	{
+		MappedGrid snapshot;
+		if(!snapshot.Create(cmd.Get("snapshot"), settings, stepCount, result.data()))
+		{
+			std::cerr << snapshot.GetError() << std::endl;
+			return 1;
+		}
+	}
+	return mismatches == 0 ? 0 : 1;
+}
+
+//Worker process of RunShards, simulates one shard until the coordinator stops
+//--shard-worker <shard> --shard-region <file>
+int RunShardWorker(const CommandLine& cmd)
+{
+	int shard = cmd.GetInt("shard-worker", 0);
+	ShardRegion region;
+	if(!region.Open(cmd.Get("shard-region")))
+	{
+		std::cerr << region.GetError() << std::endl;
+		return 1;
+	}
+	ShardRegion::Control& control = region.GetControl();
+	ShardRegion::WorkerStatus& status = region.GetStatus(shard);
+	try
+	{
+		int z0;
+		int z1;
+		region.GetShardRange(shard, z0, z1);
+		SharedMemoryTransport transport(region, shard);
+		ShardWorker worker(region.GetSettings(), region.GetSeed(), z0, z1, transport);
+		PlaneKernel::Stats stats = worker.CountCells();
+		ShardRegion::Store(status.population, stats.population);
+		ShardRegion::Store(status.alive, stats.alive);
+		ShardRegion::Store(status.ready, 1);
+
+		while(true)
+		{
+			uint64_t snapshotDone = ShardRegion::Load(status.snapshotDone);
+			if(!region.Wait([&]() { return ShardRegion::Load(control.targetGeneration) > worker.GetGeneration() || ShardRegion::Load(control.snapshotRequest) != snapshotDone; }))
+			{
+				break;
+			}
+			uint64_t snapshotRequest = ShardRegion::Load(control.snapshotRequest);
+			if(snapshotRequest != snapshotDone)
 			{
-				return (std::abs(p.x - center.x) < diameter * 0.5f && std::abs(p.y - center.y) < diameter * 0.5f && std::abs(p.z - center.z) < diameter * 0.5f);
-			};
-			break;
-		case FillShape::Sphere:
-			selectFunc = [](raylib::Vector3 p, raylib::Vector3 center, float diameter)
+				std::copy(worker.GetCells(), worker.GetCells() + worker.GetCellCount(), region.GetSnapshot() + (z0 * region.GetPlaneSize()));
+				ShardRegion::Store(status.snapshotDone, snapshotRequest);
+				continue;
+			}
+
+			stats = PlaneKernel::Stats();
+			if(!worker.Step(stats))
 			{
-				return (std::sqrtf((p.x - center.x) * (p.x - center.x)) + std::sqrtf((p.y - center.y) * (p.y - center.y)) + std::sqrtf((p.z - center.z) * (p.z - center.z))) < diameter * 0.5f;
-			};
-			break;
-		default:
-			throw std::exception("Missing switch label in Reset!");
+				break;
+			}
+			ShardRegion::Store(status.changed, stats.changed);
+			ShardRegion::Store(status.population, stats.population);
+			ShardRegion::Store(status.alive, stats.alive);
+			ShardRegion::Store(status.generation, worker.GetGeneration());
+		}
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << std::format("Shard worker {0}: {1}", shard, e.what()) << std::endl;
+		ShardRegion::Store(status.failed, 1);
+		return 1;
+	}
+	return 0;
+}
+
+//Simulates a preset without a window and streams the generations to viewers started with --view, which can connect and disconnect at any time
+//Runs until --steps generations were simulated and sent, or forever without --steps
+//--serve <socket> --preset <name> --size <n> --seed <n> --no-wrap --steps-per-second <n, 0 = as fast as possible> --steps <n>
+int RunServe(const CommandLine& cmd)
+{
+	StaticSimSettings settings;
+	if(!SetupFromCommandLine(cmd, RenderMode::Cube, settings))
+	{
+		return 1;
+	}
+	Simulation simulation(settings, static_cast<uint32_t>(cmd.GetInt("seed", static_cast<int>(std::random_device()()))));
+	std::string path = cmd.Get("serve", STREAM_DEFAULT_SOCKET);
+	path = path.empty() ? STREAM_DEFAULT_SOCKET : path;
+	StreamServer server;
+	if(!server.Listen(path))
+	{
+		std::cerr << server.GetError() << std::endl;
+		return 1;
+	}
+
+	int stepCount = std::max(cmd.GetInt("steps", 0), 0);
+	float stepsPerSecond = std::max(cmd.GetFloat("steps-per-second", 30.0f), 0.0f);
+	auto stepTime = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(stepsPerSecond > 0.0f ? 1.0 / stepsPerSecond : 0.0));
+	std::cout << std::format("Serving {0}x{1}x{2} cells on \"{3}\"", settings.size[0], settings.size[1], settings.size[2], path) << std::endl;
+
+	auto tNextStep = std::chrono::steady_clock::now();
+	auto tNextReport = tNextStep + std::chrono::seconds(1);
+	uint64_t reportBytes = 0;
+	while(stepCount == 0 || simulation.GetGeneration() < stepCount || server.HasQueued())
+	{
+		server.Accept();
+		auto tNow = std::chrono::steady_clock::now();
+		bool step = (stepCount == 0 || simulation.GetGeneration() < stepCount) && tNow >= tNextStep;
+		if(step)
+		{
+			simulation.Step();
+			//Steps that were missed are dropped instead of simulated in a burst
+			tNextStep = std::max(tNextStep + stepTime, tNow);
+		}
+		server.Publish(simulation);
+		server.Flush();
+
+		if(tNow >= tNextReport)
+		{
+			const StreamServer::Stats& stats = server.GetStats();
+			std::cout << std::format("Generation {0}: {1} viewers, {2:.2f} MB/s, {3} keyframes, {4} deltas, {5} skips", simulation.GetGeneration(), server.GetViewerCount(), (stats.bytesSent - reportBytes) / (1024.0 * 1024.0), stats.keyframes, stats.deltas, stats.skips) << std::endl;
+			reportBytes = stats.bytesSent;
+			tNextReport += std::chrono::seconds(1);
+		}
+		if(!step)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+	return 0;
+}
+
+//Window that shows the generations streamed by a server started with --serve, closing it does not affect the server or other viewers
+//The viewer has no simulation of its own, it only applies keyframes and deltas to its grid and renders it
+//--view <socket> --render-mode <mode> --color-mode <mode> --gradient <preset>
+int RunView(const CommandLine& cmd)
+{
+	std::string path = cmd.Get("view", STREAM_DEFAULT_SOCKET);
+	path = path.empty() ? STREAM_DEFAULT_SOCKET : path;
+	StreamClient client;
+	if(!client.Connect(path))
+	{
+		std::cerr << client.GetError() << std::endl;
+		return 1;
 	}
+	SettingsChanged(DynamicSettingsFromCommandLine(cmd, RenderMode::Cube));
 
-	for(int i = 0; i < settings.dimSize; i++)
+	raylib::InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Cellular Automata - Viewer");
+	raylib::SetTargetFPS(RENDERER_FPS);
+	Renderer<IntCell> renderer = Renderer<IntCell>();
+	while(!raylib::WindowShouldClose())
 	{
-		for(int k = 0; k < settings.dimSize; k++)
+		client.Update();
+		renderer.Update();
+
+		raylib::BeginDrawing();
 		{
-			for(int l = 0; l < settings.dimSize; l++)
+			raylib::ClearBackground(raylib::Color { 30, 30, 30, 255 });
+			if(client.GetGrid() != nullptr)
 			{
-				if(selectFunc(raylib::Vector3 { static_cast<float>(i), static_cast<float>(k), static_cast<float>(l) }, center, d))
-				{
-					grid.SetCell(i, k, l, RandomF01() < settings.fillProb ? settings.states - 1 : 0);
-				}
+				renderer.Render(*client.GetGrid(), dynamicSettings, gradient);
 			}
+			StreamClient::Stats stats = client.GetStats();
+			std::string status = client.GetGrid() == nullptr ? std::string("Waiting for the first keyframe") : std::format("Generation {0}", client.GetGeneration());
+			raylib::DrawText(std::format("{0}, {1:.1f} MB received, {2} skipped{3}", status, stats.bytesReceived / (1024.0 * 1024.0), stats.skipped, client.IsConnected() ? "" : " (disconnected)").c_str(), 10, 10, 20, raylib::RAYWHITE);
 		}
+		raylib::EndDrawing();
 	}
-	grid.UpdateNeighbours();
+	raylib::CloseWindow();
+	return 0;
 }
 
-void SettingsChanged(DynamicSimSettings settings)
+//Simulates a preset without a window and prints the clusters (connected components of the non empty cells) and the enclosed holes every few steps
+//--analyze --preset <name> --size <n> --seed <n> --no-wrap --steps <n> --every <n>
+int RunAnalyze(const CommandLine& cmd)
 {
-	dynamicSettings = settings;
-	gradient = Gradient::Generate(Gradient::GetPreset(dynamicSettings.gradientPreset), GRADIENT_STEPS);
+	StaticSimSettings settings;
+	if(!SetupFromCommandLine(cmd, RenderMode::Cube, settings))
+	{
+		return 1;
+	}
+	Simulation simulation(settings, static_cast<uint32_t>(cmd.GetInt("seed", static_cast<int>(std::random_device()()))));
+	int stepCount = std::max(cmd.GetInt("steps", 100), 0);
+	int every = std::max(cmd.GetInt("every", 10), 1);
+
+	Clusters clusters;
+	for(int step = 0; step <= stepCount; step += every)
+	{
+		auto tStart = std::chrono::high_resolution_clock::now();
+		clusters.Update(simulation.GetGrid());
+		Clusters::Stats stats = clusters.GetStats();
+		stats.holes = Clusters::CountHoles(simulation.GetGrid());
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+		std::string sizes;
+		for(int k = 0; k < static_cast<int>(stats.sizeHistogram.size()); k++)
+		{
+			if(stats.sizeHistogram[k] > 0)
+			{
+				sizes += std::format("{0}{1}-{2}: {3}", sizes.empty() ? "" : ", ", 1 << k, (2 << k) - 1, stats.sizeHistogram[k]);
+			}
+		}
+		std::cout << std::format("Generation {0}: {1} clusters, largest {2} of {3} cells, {4} holes ({5:.1f} ms)", simulation.GetGeneration(), stats.clusters, stats.largest, stats.cells, stats.holes, ms) << std::endl;
+		if(!sizes.empty())
+		{
+			std::cout << "  Sizes " << sizes << std::endl;
+		}
+		if(step + every <= stepCount)
+		{
+			simulation.Step(every);
+		}
+	}
+	return 0;
 }
+
+//Computes the previews of all presets that are not cached yet, e.g. to fill the cache before the window is opened for the first time
+//--previews --steps <n> --out <dir>
+int RunPreviews(const CommandLine& cmd)
+{
+	auto tStart = std::chrono::high_resolution_clock::now();
+	PresetPreviews previews(cmd.Get("out", PREVIEW_CACHE_DIR), std::max(cmd.GetInt("steps", PREVIEW_STEPS), 0), Parallel::ThreadCount());
+	for(const Preset& preset : PRESETS)
+	{
+		previews.Request(preset);
+	}
+	previews.Wait();
+	for(const Preset& preset : PRESETS)
+	{
+		std::shared_ptr<const PresetPreviews::Preview> preview = previews.Get(preset);
+		std::cout << std::format("{0}: {1} cells, {2} clusters, largest {3}, {4:.1f}% changed in the last step{5}", preset.name, preview->cells, preview->clusters, preview->largest, preview->changed * 100.0f, preview->fromCache ? " (cached)" : "") << std::endl;
+	}
+	std::cout << std::format("{0} previews in {1:.2f} s", sizeof(PRESETS) / sizeof(PRESETS[0]), std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count()) << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,340 @@
+#include "clusters.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <algorithm>
+#include <numeric>
+
+//Root of the tree of cell i, halves the path on the way
+static int Find(std::vector<int>& parents, int i)
+{
+	while(parents[i] != i)
+	{
+		parents[i] = parents[parents[i]];
+		i = parents[i];
+	}
+	return i;
+}
+
+//The smaller root becomes the parent, so every root is the first cell of its cluster in memory order
+static void Union(std::vector<int>& parents, int a, int b)
+{
+	a = Find(parents, a);
+	b = Find(parents, b);
+	if(a != b)
+	{
+		parents[std::max(a, b)] = std::min(a, b);
+	}
+}
+
+std::vector<Neighbourhood::Offset> Clusters::Links(NeighbourMode mode)
+{
+	std::vector<Neighbourhood::Offset> links;
+	Neighbourhood::Visit(mode, [&](auto stencil)
+	{
+		for(const Neighbourhood::Offset& o : decltype(stencil)::OFFSETS)
+		{
+			for(const Neighbourhood::Offset& link : { o, Neighbourhood::Offset { -o[0], -o[1], -o[2] } })
+			{
+				if(std::find(links.begin(), links.end(), link) == links.end())
+				{
+					links.push_back(link);
+				}
+			}
+		}
+	});
+	return links;
+}
+
+std::vector<Neighbourhood::Offset> Clusters::DualLinks(const std::vector<Neighbourhood::Offset>& links)
+{
+	std::vector<Neighbourhood::Offset> dual;
+	for(int dz = -1; dz <= 1; dz++)
+	{
+		for(int dy = -1; dy <= 1; dy++)
+		{
+			for(int dx = -1; dx <= 1; dx++)
+			{
+				Neighbourhood::Offset d = { dx, dy, dz };
+				//The other cells of the square or cube spanned by the cell and d, a face spans none
+				std::vector<Neighbourhood::Offset> others;
+				for(int cz : { 0, dz })
+				{
+					for(int cy : { 0, dy })
+					{
+						for(int cx : { 0, dx })
+						{
+							Neighbourhood::Offset c = { cx, cy, cz };
+							if(c != Neighbourhood::Offset {} && c != d && std::find(others.begin(), others.end(), c) == others.end())
+							{
+								others.push_back(c);
+							}
+						}
+					}
+				}
+				//Linked cells that only touch diagonally seal the gap between them, linked faces are a wall anyway
+				bool crossed = false;
+				for(const Neighbourhood::Offset& p : others)
+				{
+					for(const Neighbourhood::Offset& q : others)
+					{
+						Neighbourhood::Offset link = { q[0] - p[0], q[1] - p[1], q[2] - p[2] };
+						crossed |= Neighbourhood::Axes(link[0], link[1], link[2]) > 1 && std::find(links.begin(), links.end(), link) != links.end();
+					}
+				}
+				if(d != Neighbourhood::Offset {} && !crossed)
+				{
+					dual.push_back(d);
+				}
+			}
+		}
+	}
+	return dual;
+}
+
+void Clusters::Label(const Extent& size, const AxisWrap& wrap, const std::vector<Neighbourhood::Offset>& links)
+{
+	this->size = size;
+	int sizeX = size[0];
+	int sizeY = size[1];
+	int sizeZ = size[2];
+	int planeSize = sizeX * sizeY;
+	int cellCount = planeSize * sizeZ;
+	parents.resize(cellCount);
+	labels.resize(cellCount);
+
+	//Neighbours before a cell in memory order, which visits every pair of neighbours once
+	std::vector<std::array<int, 3>> offsets;
+	for(const Neighbourhood::Offset& link : links)
+	{
+		if(link[2] < 0 || (link[2] == 0 && (link[1] < 0 || (link[1] == 0 && link[0] < 0))))
+		{
+			offsets.push_back(link);
+		}
+	}
+	std::vector<int> deltas;
+	for(const std::array<int, 3>& offset : offsets)
+	{
+		deltas.push_back((offset[2] * planeSize) + (offset[1] * sizeX) + offset[0]);
+	}
+	auto neighbour = [&](int x, int y, int z, const std::array<int, 3>& offset) -> int
+	{
+		int n[3] = { x + offset[0], y + offset[1], z + offset[2] };
+		for(int a = 0; a < 3; a++)
+		{
+			if(n[a] < 0 || n[a] >= size[a])
+			{
+				if(!wrap[a])
+				{
+					return -1;
+				}
+				n[a] = (n[a] + size[a]) % size[a];
+			}
+		}
+		return (n[2] * planeSize) + (n[1] * sizeX) + n[0];
+	};
+	//Each slab only links cells inside of it, the planes before each slab are linked afterwards on one thread
+	int slabCount = std::min(sizeZ, Parallel::ThreadCount() * 4);
+	int slabSize = (sizeZ + slabCount - 1) / slabCount;
+	slabCount = (sizeZ + slabSize - 1) / slabSize;
+	Parallel::For(0, slabCount, [&](int slab)
+	{
+		int z0 = slab * slabSize;
+		int z1 = std::min(z0 + slabSize, sizeZ);
+		for(int i = z0 * planeSize; i < z1 * planeSize; i++)
+		{
+			parents[i] = mask[i] ? i : -1;
+		}
+		for(int z = z0; z < z1; z++)
+		{
+			//Links to the plane before the slab are made in the merge phase
+			for(int y = 0, i = z * planeSize; y < sizeY; y++)
+			{
+				for(int x = 0; x < sizeX; x++, i++)
+				{
+					if(!mask[i])
+					{
+						continue;
+					}
+					bool interior = x > 0 && x < sizeX - 1 && y > 0 && y < sizeY - 1 && z > z0;
+					int root = Find(parents, i);
+					for(size_t o = 0; o < offsets.size(); o++)
+					{
+						if(offsets[o][2] < 0 && z == z0)
+						{
+							continue;
+						}
+						int n = interior ? i + deltas[o] : neighbour(x, y, z, offsets[o]);
+						if(n < 0 || !mask[n])
+						{
+							continue;
+						}
+						int other = Find(parents, n);
+						if(other != root)
+						{
+							parents[std::max(root, other)] = std::min(root, other);
+							root = std::min(root, other);
+						}
+					}
+				}
+			}
+		}
+	});
+	for(int slab = 0; slab < slabCount; slab++)
+	{
+		int z = slab * slabSize;
+		if(z == 0 && !wrap[2])
+		{
+			continue;
+		}
+		for(int y = 0, i = z * planeSize; y < sizeY; y++)
+		{
+			for(int x = 0; x < sizeX; x++, i++)
+			{
+				if(!mask[i])
+				{
+					continue;
+				}
+				for(const std::array<int, 3>& offset : offsets)
+				{
+					int n = offset[2] < 0 ? neighbour(x, y, z, offset) : -1;
+					if(n >= 0 && mask[n])
+					{
+						Union(parents, i, n);
+					}
+				}
+			}
+		}
+	}
+
+	//Roots are numbered in memory order: count them per slab, then number them from the offset of their slab and relabel all cells
+	std::vector<int> slabRoots(slabCount, 0);
+	Parallel::For(0, slabCount, [&](int slab)
+	{
+		int roots = 0;
+		for(int i = slab * slabSize * planeSize; i < std::min((slab + 1) * slabSize, sizeZ) * planeSize; i++)
+		{
+			int root = mask[i] ? i : -1;
+			//The trees are complete, so they are only read and not compressed
+			while(root >= 0 && parents[root] != root)
+			{
+				root = parents[root];
+			}
+			labels[i] = root;
+			roots += root == i ? 1 : 0;
+		}
+		slabRoots[slab] = roots;
+	});
+	std::vector<int> firstLabel(slabCount, 0);
+	std::exclusive_scan(slabRoots.begin(), slabRoots.end(), firstLabel.begin(), 0);
+	Parallel::For(0, slabCount, [&](int slab)
+	{
+		int label = firstLabel[slab];
+		for(int i = slab * slabSize * planeSize; i < std::min((slab + 1) * slabSize, sizeZ) * planeSize; i++)
+		{
+			if(labels[i] == i)
+			{
+				parents[i] = label++;
+			}
+		}
+	});
+	sizes.assign(slabCount > 0 ? firstLabel.back() + slabRoots.back() : 0, 0);
+	Parallel::For(0, slabCount, [&](int slab)
+	{
+		//Neighbouring cells mostly belong to the same cluster, so the sizes are added in runs
+		int runLabel = -1;
+		int runLength = 0;
+		for(int i = slab * slabSize * planeSize; i < std::min((slab + 1) * slabSize, sizeZ) * planeSize; i++)
+		{
+			int label = labels[i] >= 0 ? parents[labels[i]] : -1;
+			labels[i] = label;
+			if(label != runLabel)
+			{
+				if(runLabel >= 0)
+				{
+					std::atomic_ref<int>(sizes[runLabel]).fetch_add(runLength, std::memory_order_relaxed);
+				}
+				runLabel = label;
+				runLength = 0;
+			}
+			runLength++;
+		}
+		if(runLabel >= 0)
+		{
+			std::atomic_ref<int>(sizes[runLabel]).fetch_add(runLength, std::memory_order_relaxed);
+		}
+	});
+}
+
+int Clusters::CountEnclosed(const AxisWrap& wrap) const
+{
+	if(sizes.empty())
+	{
+		return 0;
+	}
+	if(wrap[0] && wrap[1] && wrap[2])
+	{
+		return GetCount() - 1;
+	}
+	std::vector<uint8_t> border(sizes.size(), 0);
+	for(int a = 0; a < 3; a++)
+	{
+		if(wrap[a])
+		{
+			continue;
+		}
+		//Both sides of the axis, spanned by the other two axes
+		int u = (a + 1) % 3;
+		int v = (a + 2) % 3;
+		for(int side : { 0, size[a] - 1 })
+		{
+			int p[3];
+			p[a] = side;
+			for(p[v] = 0; p[v] < size[v]; p[v]++)
+			{
+				for(p[u] = 0; p[u] < size[u]; p[u]++)
+				{
+					int i = (((p[2] * size[1]) + p[1]) * size[0]) + p[0];
+					if(labels[i] >= 0)
+					{
+						border[labels[i]] = 1;
+					}
+				}
+			}
+		}
+	}
+	return GetCount() - static_cast<int>(std::count(border.begin(), border.end(), 1));
+}
+
+const std::vector<int>& Clusters::GetLabels() const
+{
+	return labels;
+}
+
+const std::vector<int>& Clusters::GetSizes() const
+{
+	return sizes;
+}
+
+int Clusters::GetCount() const
+{
+	return static_cast<int>(sizes.size());
+}
+
+Clusters::Stats Clusters::GetStats() const
+{
+	Stats stats;
+	stats.clusters = GetCount();
+	for(int size : sizes)
+	{
+		stats.largest = std::max(stats.largest, size);
+		stats.cells += size;
+		int bucket = std::bit_width(static_cast<unsigned int>(size)) - 1;
+		if(bucket >= static_cast<int>(stats.sizeHistogram.size()))
+		{
+			stats.sizeHistogram.resize(bucket + 1, 0);
+		}
+		stats.sizeHistogram[bucket]++;
+	}
+	return stats;
+}
\ No newline at end of file
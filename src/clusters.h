@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "config.h"
+#include "grid3d.h"
+#include "neighbourhood.h"
+#include "parallel.h"
+
+//Connected components (clusters) of the non empty cells of a grid, connected through the neighbourhood of the grid and across the borders if it wraps around
+//The z-planes are split into slabs that are labelled in parallel with union-find, afterwards the first plane of each slab is merged with the plane before it
+class Clusters
+{
+public:
+	struct Stats
+	{
+		int clusters = 0;
+		int largest = 0;
+		int cells = 0;
+		//Enclosed empty regions (see CountHoles), -1 if they were not counted
+		int holes = -1;
+		//Amount of clusters with a size in [2^k, 2^(k+1)) at index k
+		std::vector<int> sizeHistogram;
+	};
+
+	//Labels the clusters of the grid, if it changed since the last call
+	template<typename T>
+	void Update(const Grid3d<T>& grid)
+	{
+		if(grid.GetRevision() == cacheRevision)
+		{
+			return;
+		}
+		cacheRevision = grid.GetRevision();
+		ReadMask(grid, false);
+		Label(grid.GetSize(), grid.GetWrap(), Links(grid.GetNeighbourMode()));
+	}
+
+	//Amount of regions of empty cells that are enclosed by the clusters, i.e. that do not touch the border of the grid
+	//Empty cells are connected through the dual links of the neighbourhood (see DualLinks), so that regions do not leak through diagonal gaps between linked cells
+	//Only the sides of axes that do not wrap around are border, a grid that wraps around all axes has none, there every region besides the largest counts as enclosed
+	template<typename T>
+	static int CountHoles(const Grid3d<T>& grid)
+	{
+		Clusters empty;
+		empty.ReadMask(grid, true);
+		empty.Label(grid.GetSize(), grid.GetWrap(), DualLinks(Links(grid.GetNeighbourMode())));
+		return empty.CountEnclosed(grid.GetWrap());
+	}
+
+	//Cluster of each cell in [0, GetCount()), -1 for empty cells
+	//Clusters are numbered in the order of their first cell, so they keep their numbers while the cells before them do not change
+	const std::vector<int>& GetLabels() const;
+	//Amount of cells in each cluster
+	const std::vector<int>& GetSizes() const;
+	int GetCount() const;
+	Stats GetStats() const;
+
+private:
+	Extent size = {};
+	uint64_t cacheRevision = 0;
+	std::vector<uint8_t> mask;
+	//Union-find forest while labelling, afterwards the number of each root cell
+	std::vector<int> parents;
+	std::vector<int> labels;
+	std::vector<int> sizes;
+
+	template<typename T>
+	void ReadMask(const Grid3d<T>& grid, bool empty)
+	{
+		const Extent& size = grid.GetSize();
+		int planeSize = size[0] * size[1];
+		mask.resize(grid.GetCellCount());
+		Parallel::For(0, size[2], [&](int z)
+		{
+			for(int i = z * planeSize; i < (z + 1) * planeSize; i++)
+			{
+				mask[i] = grid[i].IsEmpty() == empty ? 1 : 0;
+			}
+		});
+	}
+
+	//Offsets through which cells are connected: those of the neighbourhood and their opposites, since a cell is connected to every cell that has it as neighbour
+	static std::vector<Neighbourhood::Offset> Links(NeighbourMode mode);
+	//Offsets through which empty cells are connected: all faces, and each edge or corner that is not crossed by a link between two other cells of the square or cube it spans
+	static std::vector<Neighbourhood::Offset> DualLinks(const std::vector<Neighbourhood::Offset>& links);
+	void Label(const Extent& size, const AxisWrap& wrap, const std::vector<Neighbourhood::Offset>& links);
+	int CountEnclosed(const AxisWrap& wrap) const;
+};
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+#include <string>
+#include <map>
+#include <array>
+#include <optional>
+#include <charconv>
+#include <iostream>
+#include <format>
+
+//Parses arguments of the form --key value and --flag
+class CommandLine
+{
+public:
+	CommandLine(int argc, char** argv)
+	{
+		program = argc > 0 ? argv[0] : "";
+		for(int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if(arg.rfind("--", 0) != 0)
+			{
+				continue;
+			}
+			std::string key = arg.substr(2);
+			bool hasValue = i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0;
+			values[key] = hasValue ? argv[++i] : "";
+		}
+	}
+
+	//Path of the executable as it was started
+	const std::string& GetProgram() const
+	{
+		return program;
+	}
+
+	bool Has(const std::string& key) const
+	{
+		return values.contains(key);
+	}
+
+	std::string Get(const std::string& key, const std::string& defaultValue = "") const
+	{
+		auto it = values.find(key);
+		return it != values.end() ? it->second : defaultValue;
+	}
+
+	//Numbers that cannot be parsed are reported and replaced by the default
+	int GetInt(const std::string& key, int defaultValue) const
+	{
+		return GetNumber(key, defaultValue);
+	}
+
+	float GetFloat(const std::string& key, float defaultValue) const
+	{
+		return GetNumber(key, defaultValue);
+	}
+
+	//Size along x, y and z given as a single value n (n along each axis) or as XxYxZ, e.g. 128x128x8
+	//Returns nothing if the value has neither form
+	std::optional<std::array<int, 3>> GetExtent(const std::string& key, int defaultValue) const
+	{
+		auto it = values.find(key);
+		if(it == values.end())
+		{
+			return std::array<int, 3> { defaultValue, defaultValue, defaultValue };
+		}
+		const std::string& value = it->second;
+		std::array<int, 3> extent;
+		size_t first = value.find('x');
+		if(first == std::string::npos)
+		{
+			if(!Parse(value, extent[0]))
+			{
+				return std::nullopt;
+			}
+			extent[1] = extent[2] = extent[0];
+			return extent;
+		}
+		size_t second = value.find('x', first + 1);
+		if(second == std::string::npos || !Parse(value.substr(0, first), extent[0]) || !Parse(value.substr(first + 1, second - first - 1), extent[1]) || !Parse(value.substr(second + 1), extent[2]))
+		{
+			return std::nullopt;
+		}
+		return extent;
+	}
+
+private:
+	std::string program;
+	std::map<std::string, std::string> values;
+
+	//True if the whole text is a number
+	template<typename V>
+	static bool Parse(const std::string& text, V& value)
+	{
+		const char* end = text.data() + text.size();
+		auto [ptr, error] = std::from_chars(text.data(), end, value);
+		return error == std::errc() && ptr == end;
+	}
+
+	template<typename V>
+	V GetNumber(const std::string& key, V defaultValue) const
+	{
+		auto it = values.find(key);
+		if(it == values.end())
+		{
+			return defaultValue;
+		}
+		V value;
+		if(!Parse(it->second, value))
+		{
+			std::cerr << std::format("Invalid value \"{0}\" for --{1}, using {2}", it->second, key, defaultValue) << std::endl;
+			return defaultValue;
+		}
+		return value;
+	}
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <map>
+#include <array>
 #include "bitmask.h";
 
 const float WINDOW_WIDTH = 1024;
@@ -16,11 +17,53 @@ const float UI_SETTING_SPACE = 5.0f;
 
 const float RENDERER_FOV = 60.0f;
 const int RENDERER_FPS = 60;
+const int RENDERER_CHUNK_SIZE = 16;
+const int RENDERER_LOD_LEVELS = 3;
+const float RENDERER_LOD_PIXELS = 3.0f;
+const float RENDERER_LOD_MAX_BIAS = 8.0f;
+
+const int EXPORT_QUEUE_SIZE = 8;
+
+const float BRUSH_MAX_RADIUS = 10.0f;
+
+const int HISTORY_KEYFRAME_INTERVAL = 32;
+const size_t HISTORY_MAX_BYTES = 64 * 1024 * 1024;
 
 const int SIM_MAX_STATES = 64;
 const int SIM_MAX_DIM_SIZE = 100;
+//Smallest size of an axis that wraps around, on smaller ones a cell would count the same cell (or itself) as several neighbours
+const int SIM_MIN_WRAP_DIM_SIZE = 3;
+const int SIM_MAX_INSTANCES = 4;
+const int GRID_BLOCK_SLAB_SIZE = 8;
+const int GRID_ACTIVE_BRICK_SIZE = 8;
+//Time per frame that the window spends on simulating, larger steps are spread over several frames
+const float SIM_FRAME_BUDGET_MS = 8.0f;
+//Every this many steps the engine that is estimated to be second best is measured again
+const int SIM_ENGINE_PROBE_INTERVAL = 32;
+const size_t GRID_ALIGNMENT = 64;
+const size_t GRID_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+const uint64_t MAPPED_SLAB_BYTES = 64 * 1024 * 1024;
+const int MAPPED_WINDOW_SLABS = 2;
+const int MAPPED_MAX_DIM_SIZE = 4096;
+
+const int SHARD_MAX_COUNT = 64;
+const int SHARD_RING_SLOTS = 4;
+
+const char* const STREAM_DEFAULT_SOCKET = "cellularautomata.sock";
+const int STREAM_KEYFRAME_INTERVAL = 64;
+const size_t STREAM_MAX_QUEUED_BYTES = 8 * 1024 * 1024;
 const int GRADIENT_STEPS = SIM_MAX_STATES;
 
+//Changes whenever the same settings and seed give different cells, so that results cached on disk (e.g. the preset previews) are computed again
+//Bump it in the same commit as any change to filling, stepping, neighbour counting or the cluster statistics of the previews
+const int SIM_VERSION = 3;
+const char* const PREVIEW_CACHE_DIR = "previews";
+const int PREVIEW_DIM_SIZE = 40;
+const int PREVIEW_STEPS = 60;
+const int PREVIEW_IMAGE_SIZE = 64;
+const int PREVIEW_WORKERS = 2;
+
 enum class RenderMode
 {
 	Quad = 0,
@@ -32,7 +75,8 @@ enum class ColorMode
 {
 	State = 0,
 	Xyz = 1,
-	Radius = 2
+	Radius = 2,
+	Cluster = 3
 };
 
 enum class GradientPreset
@@ -54,26 +98,63 @@ enum class FillShape
 	Sphere = 1
 };
 
+//Offsets of each mode are defined in neighbourhood.h
 enum NeighbourMode
 {
 	Moore = 0,
-	VonNeumann = 1
+	VonNeumann = 1,
+	FaceEdge = 2,
+	Corners = 3,
+	Below = 4
 };
 
+enum class UpdateMode
+{
+	//All cells are computed from the previous generation
+	Synchronous = 0,
+	//Cells are updated in place in a random order, each with the probability updateProb (see Grid3d::TransformAsync)
+	Asynchronous = 1
+};
+
+//How a simulation computes its steps, Auto picks the cheapest one for the current cells
+enum class StepEngine
+{
+	Auto = 0,
+	//Every cell of the grid in each step
+	Dense = 1,
+	//Only the cells around the cells that changed in the last step (see Grid3d::TransformActive)
+	Active = 2,
+	//Only a fundamental domain while the cells are symmetric (see SymmetricGrid), Dense otherwise
+	Symmetric = 3
+};
+
+//Amount of cells along x, y and z
+using Extent = std::array<int, 3>;
+//Whether the cells wrap around along x, y and z
+using AxisWrap = std::array<bool, 3>;
+
 struct StaticSimSettings
 {
-	int dimSize;
+	Extent size;
 
 	FillShape fillShape;
 	float fillDiameter;
 	float fillProb;
 
-	bool wrapSide;
+	AxisWrap wrap;
 
 	NeighbourMode neighbourMode;
 	int states;
 	BitMask surviveRule;
 	BitMask spawnRule;
+
+	//Amount of independent simulations (with different seeds) that are shown side by side
+	int instances = 1;
+
+	StepEngine engine = StepEngine::Auto;
+
+	UpdateMode updateMode = UpdateMode::Synchronous;
+	float updateProb = 0.5f;
 };
 
 struct DynamicSimSettings
@@ -83,4 +164,5 @@ struct DynamicSimSettings
 	GradientPreset gradientPreset;
 
 	float stepsPerSecond;
+	float brushRadius;
 };
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+//Counter based random numbers: every (key, counter) pair always gives the same number, no matter in which order or on which thread the numbers are drawn
+//This keeps parallel random updates reproducible for a seed, independent of the amount of threads
+namespace CounterRng
+{
+	//SplitMix64 finalizer of the key combined with the counter
+	constexpr uint64_t Get(uint64_t key, uint64_t counter)
+	{
+		uint64_t z = key + (counter + 1) * 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	//Uniform in [0, 1)
+	constexpr float GetF01(uint64_t key, uint64_t counter)
+	{
+		return static_cast<float>(Get(key, counter) >> 40) / static_cast<float>(1 << 24);
+	}
+}
\ No newline at end of file
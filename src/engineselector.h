@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <algorithm>
+
+#include "config.h"
+
+//Picks the cheapest way of stepping a grid from a cost model: the amount of cells each way would compute times the measured seconds per cell of that way
+//Ways that were not measured yet use a prior relative to the measured ones, and every SIM_ENGINE_PROBE_INTERVAL selections the second best way is taken instead,
+//so the estimates follow changes of the population (e.g. a sparse seed that grows into a dense chaotic grid)
+class EngineSelector
+{
+public:
+	enum Way
+	{
+		Dense = 0,
+		Blocked = 1,
+		Active = 2,
+		Count = 3
+	};
+
+	//work[way] is the amount of cells that way would compute, negative if it can not be used
+	Way Select(const std::array<double, Count>& work)
+	{
+		std::array<double, Count> cost;
+		for(int w = 0; w < Count; w++)
+		{
+			cost[w] = work[w] < 0.0 ? -1.0 : work[w] * SecondsPerCell(static_cast<Way>(w));
+		}
+		int best = -1;
+		int second = -1;
+		for(int w = 0; w < Count; w++)
+		{
+			if(cost[w] < 0.0)
+			{
+				continue;
+			}
+			if(best < 0 || cost[w] < cost[best])
+			{
+				second = best;
+				best = w;
+			}
+			else if(second < 0 || cost[w] < cost[second])
+			{
+				second = w;
+			}
+		}
+		selections++;
+		Way way = static_cast<Way>(std::max(best, 0));
+		if(second >= 0 && selections % SIM_ENGINE_PROBE_INTERVAL == 0)
+		{
+			way = static_cast<Way>(second);
+		}
+		uses[way]++;
+		return way;
+	}
+
+	//Records that the way computed the given amount of cells in the given time
+	void Record(Way way, double cells, double seconds)
+	{
+		if(cells <= 0.0)
+		{
+			return;
+		}
+		double sample = seconds / cells;
+		secondsPerCell[way] = secondsPerCell[way] <= 0.0 ? sample : secondsPerCell[way] * 0.75 + sample * 0.25;
+	}
+
+	//Amount of times each way was selected
+	const std::array<int, Count>& GetUses() const
+	{
+		return uses;
+	}
+
+private:
+	//Cost per cell relative to Dense, before a way was measured
+	static constexpr double PRIOR[Count] = { 1.0, 0.7, 1.5 };
+
+	std::array<double, Count> secondsPerCell = { };
+	std::array<int, Count> uses = { };
+	int selections = 0;
+
+	double SecondsPerCell(Way way) const
+	{
+		if(secondsPerCell[way] > 0.0)
+		{
+			return secondsPerCell[way];
+		}
+		//Scaled from any measured way, the scale does not matter if none was measured
+		for(int w = 0; w < Count; w++)
+		{
+			if(secondsPerCell[w] > 0.0)
+			{
+				return secondsPerCell[w] / PRIOR[w] * PRIOR[way];
+			}
+		}
+		return PRIOR[way];
+	}
+};
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+//Splits work that is done on the main thread into pieces that fit into a time budget per frame, based on the measured cost of earlier pieces
+class FrameBudget
+{
+public:
+	FrameBudget(double seconds) : budget(seconds)
+	{
+	}
+
+	//Amount of work units (between 1 and maxUnits) that should take about the budget, 1 until the first piece was measured
+	int GetUnits(int maxUnits) const
+	{
+		if(secondsPerUnit <= 0.0)
+		{
+			return 1;
+		}
+		return static_cast<int>(std::clamp(std::floor(budget / secondsPerUnit), 1.0, static_cast<double>(std::max(maxUnits, 1))));
+	}
+
+	//Records that the given amount of units took the given time, the estimate follows changes of the cost (e.g. a growing population) smoothly
+	void Record(int units, double seconds)
+	{
+		double sample = seconds / std::max(units, 1);
+		secondsPerUnit = secondsPerUnit <= 0.0 ? sample : secondsPerUnit * 0.75 + sample * 0.25;
+	}
+
+private:
+	double budget;
+	double secondsPerUnit = 0.0;
+};
\ No newline at end of file
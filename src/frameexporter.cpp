@@ -0,0 +1,200 @@
+#include "frameexporter.h"
+#include <format>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+FrameExporter::FrameExporter(ExportFormat format, const std::string& path, int width, int height, int fps, int workerCount, int queueSize)
+	: format(format), path(path), width(width), height(height), queueSize(std::max(queueSize, 1))
+{
+	if(format == ExportFormat::Png)
+	{
+		std::filesystem::create_directories(path);
+	}
+	else
+	{
+		if(path == "-")
+		{
+#ifdef _WIN32
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+			stream = stdout;
+		}
+		else
+		{
+			stream = std::fopen(path.c_str(), "wb");
+		}
+		if(stream == nullptr)
+		{
+			std::cerr << std::format("Could not open \"{0}\" for writing", path) << std::endl;
+			failed = true;
+		}
+		else
+		{
+			std::string header = std::format("YUV4MPEG2 W{0} H{1} F{2}:1 Ip A1:1 C420jpeg\n", width, height, fps);
+			std::fwrite(header.data(), 1, header.size(), stream);
+		}
+	}
+
+	for(int i = 0; i < std::max(workerCount, 1); i++)
+	{
+		workers.emplace_back(&FrameExporter::Work, this);
+	}
+}
+
+FrameExporter::~FrameExporter()
+{
+	Finish();
+}
+
+void FrameExporter::Push(raylib::Image image)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	queueChanged.wait(lock, [this]() { return static_cast<int>(queue.size()) < queueSize; });
+	queue.push_back(Frame { nextIndex++, image });
+	queueChanged.notify_all();
+}
+
+void FrameExporter::Finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(finishing)
+		{
+			return;
+		}
+		finishing = true;
+	}
+	queueChanged.notify_all();
+	for(std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	if(stream != nullptr)
+	{
+		std::fflush(stream);
+		if(stream != stdout)
+		{
+			std::fclose(stream);
+		}
+		stream = nullptr;
+	}
+}
+
+int FrameExporter::FramesWritten() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return framesWritten;
+}
+
+bool FrameExporter::Failed() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return failed;
+}
+
+void FrameExporter::Work()
+{
+	while(true)
+	{
+		Frame frame;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queueChanged.wait(lock, [this]() { return !queue.empty() || finishing; });
+			if(queue.empty())
+			{
+				return;
+			}
+			frame = queue.front();
+			queue.pop_front();
+		}
+		queueChanged.notify_all();
+
+		raylib::ImageFlipVertical(&frame.image);
+		if(format == ExportFormat::Png)
+		{
+			WritePng(frame);
+		}
+		else
+		{
+			WriteY4m(frame);
+		}
+		raylib::UnloadImage(frame.image);
+	}
+}
+
+void FrameExporter::WritePng(Frame& frame)
+{
+	std::filesystem::path file = std::filesystem::path(path) / std::format("frame_{:05}.png", frame.index);
+	bool ok = raylib::ExportImage(frame.image, file.string().c_str());
+	std::lock_guard<std::mutex> lock(mutex);
+	framesWritten++;
+	failed |= !ok;
+}
+
+//Frames are converted in parallel, but appended to the stream in order
+void FrameExporter::WriteY4m(Frame& frame)
+{
+	std::vector<unsigned char> yuv;
+	RgbaToYuv420(static_cast<const unsigned char*>(frame.image.data), width, height, yuv);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	frameWritten.wait(lock, [&]() { return nextWriteIndex == frame.index; });
+	if(stream != nullptr)
+	{
+		static const char frameHeader[] = "FRAME\n";
+		bool ok = std::fwrite(frameHeader, 1, sizeof(frameHeader) - 1, stream) == sizeof(frameHeader) - 1;
+		ok &= std::fwrite(yuv.data(), 1, yuv.size(), stream) == yuv.size();
+		failed |= !ok;
+	}
+	nextWriteIndex++;
+	framesWritten++;
+	frameWritten.notify_all();
+}
+
+//Full range BT.601 as expected by C420jpeg, chroma is averaged over 2x2 pixels
+void FrameExporter::RgbaToYuv420(const unsigned char* rgba, int width, int height, std::vector<unsigned char>& yuv)
+{
+	int chromaWidth = (width + 1) / 2;
+	int chromaHeight = (height + 1) / 2;
+	yuv.resize(width * height + chromaWidth * chromaHeight * 2);
+	unsigned char* yPlane = yuv.data();
+	unsigned char* uPlane = yPlane + width * height;
+	unsigned char* vPlane = uPlane + chromaWidth * chromaHeight;
+
+	for(int i = 0; i < width * height; i++)
+	{
+		const unsigned char* p = &rgba[i * 4];
+		yPlane[i] = static_cast<unsigned char>(std::clamp(0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2], 0.0f, 255.0f));
+	}
+	for(int cy = 0; cy < chromaHeight; cy++)
+	{
+		for(int cx = 0; cx < chromaWidth; cx++)
+		{
+			float r = 0.0f;
+			float g = 0.0f;
+			float b = 0.0f;
+			int n = 0;
+			for(int y = cy * 2; y < std::min(cy * 2 + 2, height); y++)
+			{
+				for(int x = cx * 2; x < std::min(cx * 2 + 2, width); x++)
+				{
+					const unsigned char* p = &rgba[(y * width + x) * 4];
+					r += p[0];
+					g += p[1];
+					b += p[2];
+					n++;
+				}
+			}
+			r /= n;
+			g /= n;
+			b /= n;
+			uPlane[cy * chromaWidth + cx] = static_cast<unsigned char>(std::clamp(128.0f - 0.168736f * r - 0.331264f * g + 0.5f * b, 0.0f, 255.0f));
+			vPlane[cy * chromaWidth + cx] = static_cast<unsigned char>(std::clamp(128.0f + 0.5f * r - 0.418688f * g - 0.081312f * b, 0.0f, 255.0f));
+		}
+	}
+}
\ No newline at end of file
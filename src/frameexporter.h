@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+enum class ExportFormat
+{
+	Png = 0,
+	Y4m = 1
+};
+
+//Encodes and writes frames on background worker threads
+//Frames are handed over through a bounded queue, so Push() only blocks if the workers fall behind by more than queueSize frames
+class FrameExporter
+{
+public:
+	//For Png, path is a directory that receives frame_00000.png, ...
+	//For Y4m, path is the output file or "-" for stdout, so the stream can be piped into an encoder
+	FrameExporter(ExportFormat format, const std::string& path, int width, int height, int fps, int workerCount, int queueSize);
+	~FrameExporter();
+
+	FrameExporter(const FrameExporter&) = delete;
+	FrameExporter& operator=(const FrameExporter&) = delete;
+
+	//Takes ownership of image (RGBA, bottom row first as read back from a render texture)
+	void Push(raylib::Image image);
+	//Waits until all pushed frames are written and stops the workers
+	void Finish();
+
+	int FramesWritten() const;
+	bool Failed() const;
+
+private:
+	struct Frame
+	{
+		int index;
+		raylib::Image image;
+	};
+
+	ExportFormat format;
+	std::string path;
+	int width;
+	int height;
+	int queueSize;
+	FILE* stream = nullptr;
+
+	std::vector<std::thread> workers;
+	std::deque<Frame> queue;
+	mutable std::mutex mutex;
+	std::condition_variable queueChanged;
+	std::condition_variable frameWritten;
+	int nextIndex = 0;
+	int nextWriteIndex = 0;
+	int framesWritten = 0;
+	bool finishing = false;
+	bool failed = false;
+
+	void Work();
+	void WritePng(Frame& frame);
+	void WriteY4m(Frame& frame);
+	static void RgbaToYuv420(const unsigned char* rgba, int width, int height, std::vector<unsigned char>& yuv);
+};
\ No newline at end of file
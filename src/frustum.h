@@ -0,0 +1,52 @@
+#pragma once
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+//View frustum of a perspective camera as 6 planes (a, b, c, d) with a * x + b * y + c * z + d >= 0 for points inside
+class Frustum
+{
+public:
+	Frustum(const raylib::Camera& cam, float aspect)
+	{
+		raylib::Matrix view = raylib::MatrixLookAt(cam.position, cam.target, cam.up);
+		raylib::Matrix proj = raylib::MatrixPerspective(cam.fovy * DEG2RAD, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+		raylib::Matrix m = raylib::MatrixMultiply(view, proj);
+
+		//Rows of the clip matrix, combined as in Gribb & Hartmann
+		float rows[4][4] =
+		{
+			{ m.m0, m.m4, m.m8, m.m12 },
+			{ m.m1, m.m5, m.m9, m.m13 },
+			{ m.m2, m.m6, m.m10, m.m14 },
+			{ m.m3, m.m7, m.m11, m.m15 }
+		};
+		for(int i = 0; i < 3; i++)
+		{
+			for(int k = 0; k < 4; k++)
+			{
+				planes[i * 2 + 0][k] = rows[3][k] + rows[i][k];
+				planes[i * 2 + 1][k] = rows[3][k] - rows[i][k];
+			}
+		}
+	}
+
+	//Conservative test, may return true for some boxes that are outside
+	bool IntersectsBox(const raylib::Vector3& min, const raylib::Vector3& max) const
+	{
+		for(const float* p : planes)
+		{
+			//Corner that is furthest along the plane normal
+			float x = p[0] >= 0.0f ? max.x : min.x;
+			float y = p[1] >= 0.0f ? max.y : min.y;
+			float z = p[2] >= 0.0f ? max.z : min.z;
+			if(p[0] * x + p[1] * y + p[2] * z + p[3] < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	float planes[6][4];
+};
\ No newline at end of file
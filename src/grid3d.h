@@ -4,51 +4,16 @@
 #include <algorithm>
 #include <type_traits>
 #include <tuple>
+#include <utility>
+#include <atomic>
+#include <cstdint>
 
 #include "config.h"
 #include "cell.h"
-
-static const int NEIGHBOURS_VN[6][3] =
-{
-	{ 1, 0, 0 },
-	{ 0, 1, 0 },
-	{ 0, 0, 1 },
-	{ -1, 0, 0 },
-	{ 0, -1, 0 },
-	{ 0, 0, -1 }
-};
-
-static const int NEIGHBOURS_MOORE[26][3] =
-{
-	{ -1, -1, -1 },
-	{ -1, 0, -1 },
-	{ -1, 1, -1 },
-	{ 0, -1, -1 },
-	{ 0, 0, -1 },
-	{ 0, 1, -1 },
-	{ 1, -1, -1 },
-	{ 1, 0, -1 },
-	{ 1, 1, -1 },
-
-	{ -1, -1, 0 },
-	{ -1, 0, 0 },
-	{ -1, 1, 0 },
-	{ 0, -1, 0 },
-	{ 0, 1, 0 },
-	{ 1, -1, 0 },
-	{ 1, 0, 0 },
-	{ 1, 1, 0 },
-
-	{ -1, -1, 1 },
-	{ -1, 0, 1 },
-	{ -1, 1, 1 },
-	{ 0, -1, 1 },
-	{ 0, 0, 1 },
-	{ 0, 1, 1 },
-	{ 1, -1, 1 },
-	{ 1, 0, 1 },
-	{ 1, 1, 1 }
-};
+#include "parallel.h"
+#include "gridallocator.h"
+#include "counterrng.h"
+#include "neighbourhood.h"
 
 template<typename T>
 class Grid3d
@@ -56,18 +21,26 @@ class Grid3d
 	static_assert(std::is_base_of<Cell, T>::value, "T must derive from Cell");
 
 public:
-	Grid3d(int dimSize, bool wrapAround, NeighbourMode neighbourMode)
+	//All cells are initialized to empty, which should be an empty cell (cells may store parameters like the amount of states)
+	//Cells are stored along x first, then y and then z
+	Grid3d(const Extent& size, const AxisWrap& wrap, NeighbourMode neighbourMode, const T& empty = T())
 	{
-		this->dimSize = dimSize;
-		this->wrapAround = wrapAround;
-		this->dataLen = dimSize * dimSize * dimSize;
-		this->data = std::vector<T>(this->dataLen, T());
-		this->stepData = std::vector<T>(this->dataLen, T());
+		this->size = size;
+		this->wrap = wrap;
+		this->neighbourMode = neighbourMode;
+		this->planeSize = size[0] * size[1];
+		this->dataLen = planeSize * size[2];
+		this->data = Buffer<T>(this->dataLen, empty);
+		this->stepData = Buffer<T>(this->dataLen, T());
 		this->requireNeighbourUpdate = false;
-		this->neighbourOffsets = neighbourMode == NeighbourMode::Moore ? NEIGHBOURS_MOORE : NEIGHBOURS_VN;
-		this->neighbourOffsetsLen = neighbourMode == NeighbourMode::Moore ? 26 : 6;
-		this->neighbourData = std::vector<int>(this->dataLen, 0);
-		this->stepNeighbourData = std::vector<int>(this->dataLen, 0);
+		this->neighbourData = Buffer<int>(this->dataLen, 0);
+		for(int a = 0; a < 3; a++)
+		{
+			this->bricks[a] = (size[a] + GRID_ACTIVE_BRICK_SIZE - 1) / GRID_ACTIVE_BRICK_SIZE;
+		}
+		this->dirtyBricks = std::vector<uint8_t>(bricks[0] * bricks[1] * bricks[2], 0);
+		this->revision = NextRevision();
+		this->changesBase = this->revision;
 	}
 
 	int SetCount() const
@@ -83,14 +56,43 @@ public:
 		return c;
 	}
 
-	int GetDimSize() const
+	//Amount of cells along x, y and z
+	const Extent& GetSize() const
+	{
+		return size;
+	}
+
+	int GetCellCount() const
+	{
+		return dataLen;
+	}
+
+	//Changes whenever the cell data changes and is unique across all grids, so it can be used to detect stale caches
+	uint64_t GetRevision() const
 	{
-		return dimSize;
+		return revision;
+	}
+
+	//Indices of all cells that changed between the revisions GetChangesBase() and GetRevision()
+	//Every modification starts a new list, so consumers that are not at GetChangesBase() have to do a full update
+	const std::vector<int>& GetChanges() const
+	{
+		return changes;
+	}
+
+	uint64_t GetChangesBase() const
+	{
+		return changesBase;
 	}
 
 	std::tuple<int, int, int> GetCellPos(int index) const
 	{
-		return std::tuple<int, int, int>(index % dimSize, (index / dimSize) % dimSize, index / (dimSize * dimSize));
+		return std::tuple<int, int, int>(index % size[0], (index / size[0]) % size[1], index / planeSize);
+	}
+
+	int GetIndex(int x, int y, int z) const
+	{
+		return (z * planeSize) + (y * size[0]) + x;
 	}
 
 	const T& operator [](int index) const
@@ -100,115 +102,806 @@ public:
 
 	const T& GetCell(int x, int y, int z) const
 	{
-		return data[(z * dimSize * dimSize) + (y * dimSize) + x];
+		return data[GetIndex(x, y, z)];
 	}
 
 	void SetCell(int x, int y, int z, const T& value)
 	{
-		data[(z * dimSize * dimSize) + (y * dimSize) + x] = value;
+		int index = GetIndex(x, y, z);
+		data[index] = value;
 		requireNeighbourUpdate = true;
+		changes.clear();
+		changes.push_back(index);
+		Commit(false);
 	}
 
-	void UpdateNeighbours()
+	//Changes multiple cells (pairs of index and value) as one modification
+	//Instead of recounting all neighbours before the next Transform, the counts around each changed cell are updated in place
+	void SetCells(const std::vector<std::pair<int, T>>& edits)
 	{
-		requireNeighbourUpdate = false;
+		changes.clear();
+		for(const auto& [index, value] : edits)
+		{
+			ChangeCell(index, value);
+		}
+		Commit(false);
+	}
+
+	//Replaces all cells (GetCellCount() values), neighbour counts are updated in the same way as in SetCells
+	void Load(const std::vector<T>& cells)
+	{
+		changes.clear();
 		for(int i = 0; i < dataLen; i++)
 		{
-			int x = i % dimSize;
-			int y = (i / dimSize) % dimSize;
-			int z = i / (dimSize * dimSize);
-			neighbourData[i] = CountNeighbours(x, y, z);
+			ChangeCell(i, cells[i]);
 		}
+		Commit(false);
+		//The cells may come from any other generation, so the changes of their last step are unknown
+		allDirty = true;
 	}
 
-	void ChangeNeighbours(int x, int y, int z, int delta)
+	//Replaces all cells with func(x, y, z), which is called in parallel and written straight into the cells
+	//Unlike Load, the neighbour counts are not updated per cell but counted again once before the next step that needs them
+	template<typename F>
+	void Generate(F func)
 	{
-		for(int i = 0; i < neighbourOffsetsLen; i++)
+		planeChanges.resize(size[2]);
+		Parallel::For(0, size[2], [&](int z)
 		{
-			int nx = x + neighbourOffsets[i][0];
-			int ny = y + neighbourOffsets[i][1];
-			int nz = z + neighbourOffsets[i][2];
-			if(wrapAround)
+			std::vector<int>& planeChange = planeChanges[z];
+			planeChange.clear();
+			for(int y = 0, i = z * planeSize; y < size[1]; y++)
 			{
-				nx = (nx + dimSize) % dimSize;
-				ny = (ny + dimSize) % dimSize;
-				nz = (nz + dimSize) % dimSize;
+				for(int x = 0; x < size[0]; x++, i++)
+				{
+					T value = func(x, y, z);
+					if(value != data[i])
+					{
+						data[i] = value;
+						planeChange.push_back(i);
+					}
+				}
 			}
-			else if(nx < 0 || nx >= dimSize || ny < 0 || ny >= dimSize || nz < 0 || nz >= dimSize)
-			{
-				continue;
-			}
-			int index = (nz * dimSize * dimSize) + (ny * dimSize) + nx;
-			neighbourData[index] += delta;
+		});
+		changes.clear();
+		for(const std::vector<int>& planeChange : planeChanges)
+		{
+			changes.insert(changes.end(), planeChange.begin(), planeChange.end());
 		}
+		requireNeighbourUpdate = true;
+		transformPlane = -1;
+		Commit(false);
+		//Same as in Load
+		allDirty = true;
+	}
+
+	//Whether the neighbours of the cells on one side of each axis are the cells on the opposite side
+	const AxisWrap& GetWrap() const
+	{
+		return wrap;
+	}
+
+	NeighbourMode GetNeighbourMode() const
+	{
+		return neighbourMode;
+	}
+
+	void UpdateNeighbours()
+	{
+		requireNeighbourUpdate = false;
+		Neighbourhood::Visit(neighbourMode, [&](auto hood)
+		{
+			Parallel::For(0, size[2], [&](int z)
+			{
+				for(int y = 0, i = z * planeSize; y < size[1]; y++)
+				{
+					for(int x = 0; x < size[0]; x++, i++)
+					{
+						neighbourData[i] = CountNeighbours(hood, x, y, z);
+					}
+				}
+			});
+		});
+	}
+
+	//Adds delta to the counts of all cells that have (x, y, z) as a neighbour
+	void ChangeNeighbours(int x, int y, int z, int delta)
+	{
+		Neighbourhood::Visit(neighbourMode, [&](auto hood)
+		{
+			ChangeNeighbours(hood, x, y, z, delta);
+		});
 	}
 
 	int CountNeighbours(int x, int y, int z) const
 	{
-		int c = 0;
-		for(int i = 0; i < neighbourOffsetsLen; i++)
+		return Neighbourhood::Visit(neighbourMode, [&](auto hood)
 		{
-			int nx = x + neighbourOffsets[i][0];
-			int ny = y + neighbourOffsets[i][1];
-			int nz = z + neighbourOffsets[i][2];
-			if(wrapAround)
+			return CountNeighbours(hood, x, y, z);
+		});
+	}
+
+	//func(const T& cell, int neighbours) returns the next state of a cell and may carry its own state, e.g. the rules of a simulation
+	template<typename F>
+	void Transform(F func)
+	{
+		TransformPart(func, size[2]);
+	}
+
+	//Resumable version of Transform, which computes at most the given amount of z-planes of the next generation per call and continues where the last call stopped
+	//The next generation is written to a second buffer, so the cells stay at the current generation until the call that computes the last plane swaps the buffers
+	//Returns true if that call completed the step, a step that was started before the grid was modified in any other way is discarded and started again
+	template<typename F>
+	bool TransformPart(F func, int planes)
+	{
+		if(transformPlane < 0 || transformRevision != revision)
+		{
+			if(requireNeighbourUpdate)
 			{
-				nx = (nx + dimSize) % dimSize;
-				ny = (ny + dimSize) % dimSize;
-				nz = (nz + dimSize) % dimSize;
+				UpdateNeighbours();
 			}
-			else if(nx < 0 || nx >= dimSize || ny < 0 || ny >= dimSize || nz < 0 || nz >= dimSize)
+			transformPlane = 0;
+			transformRevision = revision;
+			planeChanges.resize(size[2]);
+		}
+
+		//The neighbour counts are only read until the step is complete, so the planes can be computed in parallel and in any amount of calls
+		int z0 = transformPlane;
+		int z1 = std::min(z0 + std::max(planes, 1), size[2]);
+		Parallel::For(z0, z1, [&](int z)
+		{
+			std::vector<int>& planeChange = planeChanges[z];
+			planeChange.clear();
+			for(int i = z * planeSize; i < (z + 1) * planeSize; i++)
 			{
-				continue;
+				stepData[i] = func(data[i], neighbourData[i]);
+				if(stepData[i] != data[i])
+				{
+					planeChange.push_back(i);
+				}
 			}
-			if(GetCell(nx, ny, nz).IsAlive())
+		});
+		transformPlane = z1;
+		if(transformPlane < size[2])
+		{
+			return false;
+		}
+
+		changes.clear();
+		Neighbourhood::Visit(neighbourMode, [&](auto hood)
+		{
+			for(const std::vector<int>& planeChange : planeChanges)
 			{
-				c++;
+				for(int i : planeChange)
+				{
+					auto [x, y, z] = GetCellPos(i);
+					if(data[i].IsAlive() && !stepData[i].IsAlive())
+					{
+						ChangeNeighbours(hood, x, y, z, -1);
+					}
+					if(data[i].IsEmpty() && !stepData[i].IsEmpty())
+					{
+						ChangeNeighbours(hood, x, y, z, 1);
+					}
+					changes.push_back(i);
+				}
 			}
+		});
+		data.swap(stepData);
+		transformPlane = -1;
+		Commit(true);
+		return true;
+	}
+
+	//Fraction of the step that TransformPart already computed, 0 if no step is in progress
+	float GetTransformProgress() const
+	{
+		return transformPlane >= 0 && transformRevision == revision ? transformPlane / static_cast<float>(size[2]) : 0.0f;
+	}
+
+	//Same result as Transform, but only computes the cells in the bricks (GRID_ACTIVE_BRICK_SIZE^3 cells) that contain a cell which changed since the last step
+	//and in their neighbouring bricks. All other cells keep their state, since neither they nor their neighbours changed since they were last computed
+	//Returns the amount of cells that were computed
+	template<typename F>
+	int TransformActive(F func)
+	{
+		if(requireNeighbourUpdate)
+		{
+			UpdateNeighbours();
 		}
-		return c;
+		int cellCount = UpdateActiveBricks();
+		brickChanges.resize(activeBricks.size());
+		Parallel::For(0, static_cast<int>(activeBricks.size()), [&](int b)
+		{
+			std::vector<std::pair<int, T>>& brickChange = brickChanges[b];
+			brickChange.clear();
+			int from[3];
+			int to[3];
+			BrickBounds(activeBricks[b], from, to);
+			for(int z = from[2]; z < to[2]; z++)
+			{
+				for(int y = from[1]; y < to[1]; y++)
+				{
+					for(int i = GetIndex(from[0], y, z), x = from[0]; x < to[0]; x++, i++)
+					{
+						T next = func(data[i], neighbourData[i]);
+						if(next != data[i])
+						{
+							brickChange.push_back(std::pair<int, T>(i, next));
+						}
+					}
+				}
+			}
+		});
+
+		//All next states are known at this point, so they can be written in place
+		changes.clear();
+		Neighbourhood::Visit(neighbourMode, [&](auto hood)
+		{
+			for(const std::vector<std::pair<int, T>>& brickChange : brickChanges)
+			{
+				for(const auto& [i, next] : brickChange)
+				{
+					auto [x, y, z] = GetCellPos(i);
+					if(data[i].IsAlive() && !next.IsAlive())
+					{
+						ChangeNeighbours(hood, x, y, z, -1);
+					}
+					if(data[i].IsEmpty() && !next.IsEmpty())
+					{
+						ChangeNeighbours(hood, x, y, z, 1);
+					}
+					data[i] = next;
+					changes.push_back(i);
+				}
+			}
+		});
+		transformPlane = -1;
+		Commit(true);
+		return cellCount;
 	}
 
-	typedef T (*ModFunc)(const T& cell, int neighbours);
-	void Transform(ModFunc func)
+	//Amount of cells that TransformActive would compute in the next step
+	int CountActiveCells()
+	{
+		return UpdateActiveBricks();
+	}
+
+	//Asynchronous step: cells are updated in place, so a cell already sees the new states of the neighbours that were updated before it
+	//The cells are split into colour classes by the parity of their coordinates (2x2x2), so no two cells of a class are neighbours and each class can be updated in parallel
+	//If the grid wraps around an axis with an odd size, the last layer of that axis gets a class of its own, because it touches the first layer
+	//The classes are updated in a random order and each cell only with the probability updateProb, both drawn from CounterRng with the key, so the result does not depend on the threads
+	template<typename F>
+	void TransformAsync(F func, uint64_t key, float updateProb)
 	{
 		if(requireNeighbourUpdate)
 		{
 			UpdateNeighbours();
 		}
+		transformPlane = -1;
 
-		stepNeighbourData = neighbourData;
-		for(int i = 0; i < dataLen; i++)
+		//Coordinates of each class on each axis
+		std::array<std::vector<std::vector<int>>, 3> axisClasses;
+		for(int a = 0; a < 3; a++)
 		{
-			int x = i % dimSize;
-			int y = (i / dimSize) % dimSize;
-			int z = i / (dimSize * dimSize);
-			const T& cell = GetCell(x, y, z);
-			bool wasAlive = cell.IsAlive();
-			bool wasEmpty = cell.IsEmpty();
-			const T& nextCell = func(cell, stepNeighbourData[i]);
-			stepData[i] = nextCell;
-			if(wasAlive && !nextCell.IsAlive())
+			axisClasses[a].resize(wrap[a] && size[a] % 2 == 1 && size[a] > 1 ? 3 : 2);
+			for(int c = 0; c < size[a]; c++)
 			{
-				ChangeNeighbours(x, y, z, -1);
+				axisClasses[a][axisClasses[a].size() == 3 && c == size[a] - 1 ? 2 : c % 2].push_back(c);
 			}
-			if(wasEmpty && !nextCell.IsEmpty())
+		}
+		int countX = static_cast<int>(axisClasses[0].size());
+		int countY = static_cast<int>(axisClasses[1].size());
+		int classCount = countX * countY * static_cast<int>(axisClasses[2].size());
+		std::vector<int> order(classCount);
+		for(int c = 0; c < classCount; c++)
+		{
+			order[c] = c;
+		}
+		for(int c = classCount - 1; c > 0; c--)
+		{
+			std::swap(order[c], order[CounterRng::Get(key, dataLen + c) % (c + 1)]);
+		}
+
+		planeChanges.resize(size[2]);
+		for(std::vector<int>& planeChange : planeChanges)
+		{
+			planeChange.clear();
+		}
+		Neighbourhood::Visit(neighbourMode, [&](auto hood)
+		{
+			for(int c : order)
 			{
-				ChangeNeighbours(x, y, z, 1);
+				const std::vector<int>& xs = axisClasses[0][c % countX];
+				const std::vector<int>& ys = axisClasses[1][(c / countX) % countY];
+				const std::vector<int>& zs = axisClasses[2][c / (countX * countY)];
+				//The counts of this class are only changed by cells of other classes, the counts that the cells of this class change belong to other classes
+				Parallel::For(0, static_cast<int>(zs.size()), [&](int zi)
+				{
+					int z = zs[zi];
+					for(int y : ys)
+					{
+						for(int x : xs)
+						{
+							int i = GetIndex(x, y, z);
+							if(updateProb < 1.0f && CounterRng::GetF01(key, i) >= updateProb)
+							{
+								continue;
+							}
+							T next = func(data[i], neighbourData[i]);
+							if(next == data[i])
+							{
+								continue;
+							}
+							if(data[i].IsAlive() != next.IsAlive())
+							{
+								ChangeNeighboursShared(hood, x, y, z, next.IsAlive() ? 1 : -1);
+							}
+							data[i] = next;
+							planeChanges[z].push_back(i);
+						}
+					}
+				});
 			}
+		});
+
+		changes.clear();
+		for(const std::vector<int>& planeChange : planeChanges)
+		{
+			changes.insert(changes.end(), planeChange.begin(), planeChange.end());
 		}
-		data = stepData;
+		Commit(true);
+		//Cells that were skipped may change in the next step without any change around them
+		allDirty = true;
+	}
+
+	//Advances the grid by the given amount of generations with the same result as calling Transform(func) that often, but with a single pass over the grid
+	//The grid is split into slabs of slabSize planes along z, each slab is loaded into a local buffer together with a halo of one plane per generation on both sides
+	//and then advanced in place, where the valid range shrinks by one plane per generation (trapezoid), so no slab depends on the intermediate generations of another one
+	//The neighbour counts are only recounted if Transform is called afterwards
+	template<typename F>
+	void TransformBlocked(F func, int generations, int slabSize = GRID_BLOCK_SLAB_SIZE)
+	{
+		if(generations <= 0)
+		{
+			return;
+		}
+		slabSize = std::clamp(slabSize, 1, size[2]);
+		int slabs = (size[2] + slabSize - 1) / slabSize;
+		//x and y coordinate of the neighbour at offset -1, 0 and 1 (-1 outside of the grid)
+		std::array<std::vector<int>, 2> wrapIndex;
+		for(int a = 0; a < 2; a++)
+		{
+			wrapIndex[a].resize(3 * size[a]);
+			for(int d = -1; d <= 1; d++)
+			{
+				for(int x = 0; x < size[a]; x++)
+				{
+					int n = x + d;
+					wrapIndex[a][(d + 1) * size[a] + x] = wrap[a] ? (n + size[a]) % size[a] : (n >= 0 && n < size[a] ? n : -1);
+				}
+			}
+		}
+		//Static split, so each thread works on the same part of the grid in every call, which is also the part whose pages it touched first (see GridMemory)
+		Parallel::ForStatic(0, slabs, [&](int slab)
+		{
+			int z0 = slab * slabSize;
+			int z1 = std::min(z0 + slabSize, size[2]);
+			int depth = (z1 - z0) + generations * 2;
+			//Only the alive flags and valid planes have to be cleared, everything else is written before it is read
+			static thread_local BlockScratch scratch;
+			scratch.Resize(depth, planeSize);
+			std::vector<T>& curr = scratch.curr;
+			std::vector<T>& next = scratch.next;
+			std::vector<uint8_t>& alive = scratch.alive;
+			std::vector<uint8_t>& planeValid = scratch.planeValid;
+			std::fill(alive.begin(), alive.end(), 0);
+			std::fill(planeValid.begin(), planeValid.end(), 0);
+
+			//Local plane lz is global plane z0 - generations + lz
+			for(int lz = 0; lz < depth; lz++)
+			{
+				int z = z0 - generations + lz;
+				if(wrap[2])
+				{
+					z = ((z % size[2]) + size[2]) % size[2];
+				}
+				else if(z < 0 || z >= size[2])
+				{
+					continue;
+				}
+				planeValid[lz] = 1;
+				std::copy(data.begin() + z * planeSize, data.begin() + (z + 1) * planeSize, curr.begin() + lz * planeSize);
+				for(int i = 0; i < planeSize; i++)
+				{
+					alive[lz * planeSize + i] = curr[lz * planeSize + i].IsAlive() ? 1 : 0;
+				}
+			}
+
+			for(int g = 1; g <= generations; g++)
+			{
+				Neighbourhood::Visit(neighbourMode, [&](auto hood)
+				{
+					CountBlockNeighbours(hood, scratch, g, depth - g, wrapIndex);
+				});
+				for(int lz = g; lz < depth - g; lz++)
+				{
+					if(!planeValid[lz])
+					{
+						continue;
+					}
+					//All counts of this generation are known at this point, so the alive flags can be overwritten right away
+					for(int i = lz * planeSize; i < (lz + 1) * planeSize; i++)
+					{
+						next[i] = func(curr[i], scratch.counts[i]);
+						alive[i] = next[i].IsAlive() ? 1 : 0;
+					}
+				}
+				//Planes outside of the valid range are stale after the swap, but they are not read by later generations anymore
+				curr.swap(next);
+			}
+
+			std::copy(curr.begin() + generations * planeSize, curr.begin() + (generations + z1 - z0) * planeSize, stepData.begin() + z0 * planeSize);
+		});
+
+		changes.clear();
+		for(int i = 0; i < dataLen; i++)
+		{
+			if(stepData[i] != data[i])
+			{
+				changes.push_back(i);
+			}
+		}
+		data.swap(stepData);
+		requireNeighbourUpdate = true;
+		Commit(true);
+		//Cells that changed in the last generation but have the same state as before the first one are not in the changes
+		allDirty = true;
 	}
 
 private:
-	int dimSize;
-	bool wrapAround;
+	//Per cell buffers, see GridMemory
+	template<typename U>
+	using Buffer = std::vector<U, GridAllocator<U>>;
+
+	Extent size;
+	AxisWrap wrap;
+	NeighbourMode neighbourMode;
+	int planeSize;
 	int dataLen;
-	std::vector<T> data;
-	std::vector<T> stepData;
+	Buffer<T> data;
+	Buffer<T> stepData;
 	bool requireNeighbourUpdate;
-	const int(*neighbourOffsets)[3];
-	int neighbourOffsetsLen;
-	std::vector<int> neighbourData;
-	std::vector<int> stepNeighbourData;
+	Buffer<int> neighbourData;
+	//Progress of TransformPart: next plane to compute (-1 if no step is in progress), revision at the start of the step and the changed cells of each plane
+	int transformPlane = -1;
+	uint64_t transformRevision = 0;
+	std::vector<std::vector<int>> planeChanges;
+	//Bricks with cells that changed since the last step (all of them if that is unknown) and the bricks TransformActive computes for them
+	int bricks[3];
+	std::vector<uint8_t> dirtyBricks;
+	bool allDirty = true;
+	std::vector<int> activeBricks;
+	int activeCells = 0;
+	uint64_t activeRevision = 0;
+	std::vector<std::vector<std::pair<int, T>>> brickChanges;
+	uint64_t revision;
+	uint64_t changesBase;
+	std::vector<int> changes;
+
+	//Buffers of a TransformBlocked slab (depth planes), kept per thread so that repeated calls do not allocate
+	struct BlockScratch
+	{
+		std::vector<T> curr;
+		std::vector<T> next;
+		std::vector<uint8_t> alive;
+		std::vector<uint8_t> planeValid;
+		std::vector<uint8_t> counts;
+		std::vector<uint8_t> sums;
+		std::vector<uint8_t> rowSums;
+
+		void Resize(int depth, int planeSize)
+		{
+			curr.resize(depth * planeSize);
+			next.resize(depth * planeSize);
+			alive.resize(depth * planeSize);
+			planeValid.resize(depth);
+			counts.resize(depth * planeSize);
+			sums.resize(depth * planeSize);
+			rowSums.resize(planeSize);
+		}
+	};
+
+	//Writes the amount of alive neighbours of all cells in the planes [from, to) of a TransformBlocked slab to counts
+	//The Moore neighbourhood is summed separably along x, y and z (3x3x3 box minus the cell itself), other neighbourhoods cell by cell
+	//Planes that are not valid are never set alive, so only x and y have to be checked against the borders
+	template<typename Hood>
+	void CountBlockNeighbours(Hood, BlockScratch& scratch, int from, int to, const std::array<std::vector<int>, 2>& wrapIndex) const
+	{
+		const std::vector<uint8_t>& alive = scratch.alive;
+		const std::vector<uint8_t>& planeValid = scratch.planeValid;
+		std::vector<uint8_t>& counts = scratch.counts;
+		std::vector<uint8_t>& sums = scratch.sums;
+		std::vector<uint8_t>& rowSums = scratch.rowSums;
+		int sizeX = size[0];
+		int sizeY = size[1];
+		const int* left = &wrapIndex[0][0];
+		const int* right = &wrapIndex[0][2 * sizeX];
+		const int* up = &wrapIndex[1][0];
+		const int* down = &wrapIndex[1][2 * sizeY];
+		if constexpr(Hood::MODE == NeighbourMode::Moore)
+		{
+			//3x3 sums of each plane in [from - 1, to + 1)
+			for(int lz = from - 1; lz < to + 1; lz++)
+			{
+				uint8_t* plane = &sums[lz * planeSize];
+				if(!planeValid[lz])
+				{
+					std::fill(plane, plane + planeSize, 0);
+					continue;
+				}
+				const uint8_t* a = &alive[lz * planeSize];
+				for(int y = 0; y < sizeY; y++)
+				{
+					const uint8_t* row = &a[y * sizeX];
+					for(int x = 0; x < sizeX; x++)
+					{
+						rowSums[y * sizeX + x] = row[x] + (left[x] >= 0 ? row[left[x]] : 0) + (right[x] >= 0 ? row[right[x]] : 0);
+					}
+				}
+				for(int y = 0; y < sizeY; y++)
+				{
+					const uint8_t* above = up[y] >= 0 ? &rowSums[up[y] * sizeX] : nullptr;
+					const uint8_t* below = down[y] >= 0 ? &rowSums[down[y] * sizeX] : nullptr;
+					const uint8_t* row = &rowSums[y * sizeX];
+					for(int x = 0; x < sizeX; x++)
+					{
+						plane[y * sizeX + x] = row[x] + (above ? above[x] : 0) + (below ? below[x] : 0);
+					}
+				}
+			}
+			for(int lz = from; lz < to; lz++)
+			{
+				for(int i = lz * planeSize; i < (lz + 1) * planeSize; i++)
+				{
+					counts[i] = sums[i - planeSize] + sums[i] + sums[i + planeSize] - alive[i];
+				}
+			}
+		}
+		else
+		{
+			for(int lz = from; lz < to; lz++)
+			{
+				for(int y = 0; y < sizeY; y++)
+				{
+					bool innerRow = y > 0 && y < sizeY - 1;
+					for(int x = 0, i = (lz * planeSize) + (y * sizeX); x < sizeX; x++, i++)
+					{
+						int c = 0;
+						if(innerRow && x > 0 && x < sizeX - 1)
+						{
+							Hood::ForEach([&](const Neighbourhood::Offset& o)
+							{
+								c += alive[i + Hood::Flat(o, sizeX, planeSize)];
+							});
+						}
+						else
+						{
+							Hood::ForEach([&](const Neighbourhood::Offset& o)
+							{
+								int nx = wrapIndex[0][(o[0] + 1) * sizeX + x];
+								int ny = wrapIndex[1][(o[1] + 1) * sizeY + y];
+								if(nx >= 0 && ny >= 0)
+								{
+									c += alive[((lz + o[2]) * planeSize) + (ny * sizeX) + nx];
+								}
+							});
+						}
+						counts[i] = static_cast<uint8_t>(c);
+					}
+				}
+			}
+		}
+	}
+
+	//Whether all cells within one cell of (x, y, z) are inside of the grid, so the neighbours are at constant offsets in the cell data
+	bool Interior(int x, int y, int z) const
+	{
+		return x > 0 && y > 0 && z > 0 && x < size[0] - 1 && y < size[1] - 1 && z < size[2] - 1;
+	}
+
+	//The cells that have (x, y, z) as a neighbour are at the negated offsets, which only differs from the offsets themselves for directional neighbourhoods
+	template<typename Hood>
+	void ChangeNeighbours(Hood, int x, int y, int z, int delta)
+	{
+		if(Interior(x, y, z))
+		{
+			int* counts = &neighbourData[GetIndex(x, y, z)];
+			Hood::ForEach([&](const Neighbourhood::Offset& o)
+			{
+				counts[-Hood::Flat(o, size[0], planeSize)] += delta;
+			});
+			return;
+		}
+		Hood::ForEach([&](const Neighbourhood::Offset& o)
+		{
+			int index = NeighbourIndex(x, y, z, Neighbourhood::Offset { -o[0], -o[1], -o[2] });
+			if(index >= 0)
+			{
+				neighbourData[index] += delta;
+			}
+		});
+	}
+
+	//Same as ChangeNeighbours, for cells that may share neighbours with cells that are changed on other threads at the same time
+	template<typename Hood>
+	void ChangeNeighboursShared(Hood, int x, int y, int z, int delta)
+	{
+		Hood::ForEach([&](const Neighbourhood::Offset& o)
+		{
+			int index = NeighbourIndex(x, y, z, Neighbourhood::Offset { -o[0], -o[1], -o[2] });
+			if(index >= 0)
+			{
+				std::atomic_ref<int>(neighbourData[index]).fetch_add(delta, std::memory_order_relaxed);
+			}
+		});
+	}
+
+	template<typename Hood>
+	int CountNeighbours(Hood, int x, int y, int z) const
+	{
+		int c = 0;
+		if(Interior(x, y, z))
+		{
+			const T* cell = &data[GetIndex(x, y, z)];
+			Hood::ForEach([&](const Neighbourhood::Offset& o)
+			{
+				c += cell[Hood::Flat(o, size[0], planeSize)].IsAlive() ? 1 : 0;
+			});
+			return c;
+		}
+		Hood::ForEach([&](const Neighbourhood::Offset& o)
+		{
+			int index = NeighbourIndex(x, y, z, o);
+			if(index >= 0 && data[index].IsAlive())
+			{
+				c++;
+			}
+		});
+		return c;
+	}
+
+	//Index of the cell at the offset from (x, y, z), wrapped around on the axes that wrap, -1 if it is outside of the grid
+	int NeighbourIndex(int x, int y, int z, const Neighbourhood::Offset& offset) const
+	{
+		int n[3] = { x + offset[0], y + offset[1], z + offset[2] };
+		for(int a = 0; a < 3; a++)
+		{
+			if(wrap[a])
+			{
+				n[a] = (n[a] + size[a]) % size[a];
+			}
+			else if(n[a] < 0 || n[a] >= size[a])
+			{
+				return -1;
+			}
+		}
+		return GetIndex(n[0], n[1], n[2]);
+	}
+
+	//Ends a modification of the cells in changes, whose bricks become dirty. A step replaces the dirty bricks of earlier modifications
+	void Commit(bool step)
+	{
+		if(step)
+		{
+			std::fill(dirtyBricks.begin(), dirtyBricks.end(), 0);
+			allDirty = false;
+		}
+		for(int i : changes)
+		{
+			auto [x, y, z] = GetCellPos(i);
+			dirtyBricks[BrickIndex(x / GRID_ACTIVE_BRICK_SIZE, y / GRID_ACTIVE_BRICK_SIZE, z / GRID_ACTIVE_BRICK_SIZE)] = 1;
+		}
+		changesBase = revision;
+		revision = NextRevision();
+	}
+
+	int BrickIndex(int bx, int by, int bz) const
+	{
+		return (bz * bricks[0] * bricks[1]) + (by * bricks[0]) + bx;
+	}
+
+	//Cells [from, to) of a brick on each axis
+	void BrickBounds(int brick, int from[3], int to[3]) const
+	{
+		int b[3] = { brick % bricks[0], (brick / bricks[0]) % bricks[1], brick / (bricks[0] * bricks[1]) };
+		for(int a = 0; a < 3; a++)
+		{
+			from[a] = b[a] * GRID_ACTIVE_BRICK_SIZE;
+			to[a] = std::min(from[a] + GRID_ACTIVE_BRICK_SIZE, size[a]);
+		}
+	}
+
+	//Collects the dirty bricks and their neighbours (across the borders if the grid wraps around), returns the amount of cells in them
+	int UpdateActiveBricks()
+	{
+		if(activeRevision == revision)
+		{
+			return activeCells;
+		}
+		activeRevision = revision;
+		std::vector<uint8_t> active(dirtyBricks.size(), allDirty ? 1 : 0);
+		for(int bz = 0; bz < bricks[2] && !allDirty; bz++)
+		{
+			for(int by = 0; by < bricks[1]; by++)
+			{
+				for(int bx = 0; bx < bricks[0]; bx++)
+				{
+					if(!dirtyBricks[BrickIndex(bx, by, bz)])
+					{
+						continue;
+					}
+					for(int dz = -1; dz <= 1; dz++)
+					{
+						for(int dy = -1; dy <= 1; dy++)
+						{
+							for(int dx = -1; dx <= 1; dx++)
+							{
+								int n[3] = { bx + dx, by + dy, bz + dz };
+								bool inside = true;
+								for(int a = 0; a < 3; a++)
+								{
+									if(wrap[a])
+									{
+										n[a] = (n[a] + bricks[a]) % bricks[a];
+									}
+									inside = inside && n[a] >= 0 && n[a] < bricks[a];
+								}
+								if(inside)
+								{
+									active[BrickIndex(n[0], n[1], n[2])] = 1;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+		activeBricks.clear();
+		activeCells = 0;
+		for(int brick = 0; brick < static_cast<int>(active.size()); brick++)
+		{
+			if(active[brick])
+			{
+				int from[3];
+				int to[3];
+				BrickBounds(brick, from, to);
+				activeBricks.push_back(brick);
+				activeCells += (to[0] - from[0]) * (to[1] - from[1]) * (to[2] - from[2]);
+			}
+		}
+		return activeCells;
+	}
+
+	void ChangeCell(int index, const T& value)
+	{
+		const T& cell = data[index];
+		if(value == cell)
+		{
+			return;
+		}
+		if(!requireNeighbourUpdate && cell.IsAlive() != value.IsAlive())
+		{
+			auto [x, y, z] = GetCellPos(index);
+			ChangeNeighbours(x, y, z, value.IsAlive() ? 1 : -1);
+		}
+		data[index] = value;
+		changes.push_back(index);
+	}
+
+	static uint64_t NextRevision()
+	{
+		static std::atomic<uint64_t> counter = 0;
+		return ++counter;
+	}
 };
@@ -0,0 +1,189 @@
+#pragma once
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <string>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "config.h"
+#include "parallel.h"
+
+//Allocation of the large grid buffers: aligned to cache lines, optionally backed by transparent huge pages
+//and first touched by the same threads (with the same split as Parallel::ForStatic) that process the buffers later, so that pages are local on NUMA systems
+namespace GridMemory
+{
+	struct Options
+	{
+		bool hugePages = true;
+		bool firstTouch = true;
+	};
+
+	//Only counts the buffers of at least one huge page
+	struct Stats
+	{
+		std::atomic<uint64_t> bytes = 0;
+		std::atomic<int> buffers = 0;
+		std::atomic<int> touchThreads = 0;
+	};
+
+	//inline instead of static, so that all translation units share them
+	inline Options& GetOptions()
+	{
+		static Options options;
+		return options;
+	}
+
+	inline Stats& GetStats()
+	{
+		static Stats stats;
+		return stats;
+	}
+
+	//Buffers of at least one huge page are aligned to huge pages, everything else to cache lines
+	static size_t Alignment(size_t bytes)
+	{
+		return bytes >= GRID_HUGE_PAGE_SIZE ? GRID_HUGE_PAGE_SIZE : GRID_ALIGNMENT;
+	}
+
+	static size_t RoundedSize(size_t bytes)
+	{
+		size_t alignment = Alignment(bytes);
+		return (bytes + alignment - 1) / alignment * alignment;
+	}
+
+	static void* Allocate(size_t bytes)
+	{
+		size_t size = RoundedSize(bytes);
+		size_t alignment = Alignment(bytes);
+		uint8_t* p = static_cast<uint8_t*>(::operator new(size, std::align_val_t(alignment)));
+		if(alignment != GRID_HUGE_PAGE_SIZE)
+		{
+			return p;
+		}
+
+		Stats& stats = GetStats();
+		stats.bytes += size;
+		stats.buffers++;
+#ifdef __linux__
+		if(GetOptions().hugePages)
+		{
+			madvise(p, size, MADV_HUGEPAGE);
+		}
+#endif
+		//Large allocations come directly from the operating system, so no page is placed before it is written here
+		if(GetOptions().firstTouch)
+		{
+			static const size_t pageSize = 4096;
+			Parallel::ForStatic(0, static_cast<int>(size / pageSize), [p](int page)
+			{
+				p[page * pageSize] = 0;
+			});
+			stats.touchThreads = Parallel::Pool().GetThreadCount() + 1;
+		}
+		else
+		{
+			stats.touchThreads = 1;
+		}
+		return p;
+	}
+
+	static void Free(void* p, size_t bytes)
+	{
+		size_t size = RoundedSize(bytes);
+		size_t alignment = Alignment(bytes);
+		if(alignment == GRID_HUGE_PAGE_SIZE)
+		{
+			Stats& stats = GetStats();
+			stats.bytes -= size;
+			stats.buffers--;
+		}
+		::operator delete(p, std::align_val_t(alignment));
+	}
+
+	//Amount of sampled pages of [p, p + bytes) on each NUMA node, empty if the placement can not be queried
+	static std::vector<int> PagesPerNode(const void* p, size_t bytes, int samples = 256)
+	{
+		std::vector<int> counts;
+#ifdef __linux__
+		uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+		std::vector<void*> pages(samples);
+		std::vector<int> status(samples, -1);
+		for(int i = 0; i < samples; i++)
+		{
+			uintptr_t address = reinterpret_cast<uintptr_t>(p) + (bytes * i / samples);
+			pages[i] = reinterpret_cast<void*>(address - (address % pageSize));
+		}
+		//move_pages without target nodes only reports the node of each page
+		if(syscall(SYS_move_pages, 0, samples, pages.data(), nullptr, status.data(), 0) != 0)
+		{
+			return counts;
+		}
+		for(int node : status)
+		{
+			if(node >= 0)
+			{
+				counts.resize(std::max(static_cast<int>(counts.size()), node + 1), 0);
+				counts[node]++;
+			}
+		}
+#endif
+		return counts;
+	}
+
+	//Memory of the whole process that is actually backed by transparent huge pages, -1 if unknown
+	static int64_t HugePageBytesInUse()
+	{
+		std::ifstream file("/proc/self/smaps_rollup");
+		std::string line;
+		while(std::getline(file, line))
+		{
+			if(line.rfind("AnonHugePages:", 0) == 0)
+			{
+				std::istringstream stream(line.substr(14));
+				int64_t kb = 0;
+				stream >> kb;
+				return kb * 1024;
+			}
+		}
+		return -1;
+	}
+}
+
+//Allocator for std::vector that uses GridMemory
+template<typename T>
+class GridAllocator
+{
+public:
+	typedef T value_type;
+
+	GridAllocator() = default;
+
+	template<typename U>
+	GridAllocator(const GridAllocator<U>&)
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(GridMemory::Allocate(count * sizeof(T)));
+	}
+
+	void deallocate(T* p, size_t count)
+	{
+		GridMemory::Free(p, count * sizeof(T));
+	}
+
+	template<typename U>
+	bool operator==(const GridAllocator<U>&) const
+	{
+		return true;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+//Exchange of the boundary planes between neighbouring shards of a grid that is split along z
+//Face 0 is the lowest plane of a shard and face 1 the highest one, the shard below receives face 0 and the shard above face 1
+//Implementations only have to deliver the planes of each face in order, e.g. through shared memory or a network connection
+class HaloTransport
+{
+public:
+	virtual ~HaloTransport() = default;
+
+	//False if there is no shard on that side, e.g. at the border of a grid without wrapping
+	virtual bool HasNeighbour(int face) const = 0;
+	//Publishes the plane of the given face of this shard for a generation, may block until the neighbour received older generations
+	virtual bool Send(int face, uint64_t generation, const uint8_t* plane) = 0;
+	//Blocks until the neighbour on the side of face published its adjacent plane for a generation and copies it to plane
+	virtual bool Receive(int face, uint64_t generation, uint8_t* plane) = 0;
+};
\ No newline at end of file
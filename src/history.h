@@ -0,0 +1,272 @@
+#pragma once
+#include <type_traits>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "config.h"
+#include "grid3d.h"
+
+//Bounded history of generations for stepping backwards and scrubbing
+//Every HISTORY_KEYFRAME_INTERVAL generations a full keyframe (run length encoded states) is stored, all other generations only store the cells that changed
+//compared to the previous generation (gap encoded indices + xor of the states), so that a generation can be reached from either side
+//Once the encoded size exceeds HISTORY_MAX_BYTES, the oldest generations are dropped
+//T must be convertible to int, provide WithValue(int) and each cell state has to fit into a byte
+template<typename T>
+class History
+{
+	static_assert(std::is_base_of<Cell, T>::value, "T must derive from Cell");
+
+public:
+	//Drops all generations and stores the grid as generation 0
+	void Reset(const Grid3d<T>& grid)
+	{
+		entries.clear();
+		bytes = 0;
+		first = 0;
+		ReadStates(grid, state);
+		stateGeneration = 0;
+		entries.push_back(Entry { true, EncodeKeyframe(state) });
+		bytes += entries.back().data.size();
+	}
+
+	//Stores the grid as the generation after the current position, any generations after the current position are dropped
+	void Record(const Grid3d<T>& grid)
+	{
+		DropAfter(stateGeneration);
+		ReadStates(grid, nextState);
+
+		int generation = stateGeneration + 1;
+		Entry entry;
+		entry.keyframe = (generation - LastKeyframe(stateGeneration)) >= HISTORY_KEYFRAME_INTERVAL;
+		entry.data = entry.keyframe ? EncodeKeyframe(nextState) : EncodeDelta(state, nextState);
+		bytes += entry.data.size();
+		entries.push_back(std::move(entry));
+		std::swap(state, nextState);
+		stateGeneration = generation;
+
+		while(bytes > HISTORY_MAX_BYTES && entries.size() > 1)
+		{
+			DropFirst();
+		}
+	}
+
+	//Drops all generations after the current position, e.g. after the grid was edited
+	void Truncate()
+	{
+		DropAfter(stateGeneration);
+	}
+
+	//Loads the generation (between GetOldest() and GetNewest()) into the grid and makes it the current position
+	//The cells are created from an existing cell of the grid with WithValue(), so that parameters stored in the cells are kept
+	void Restore(int generation, Grid3d<T>& grid)
+	{
+		generation = std::clamp(generation, GetOldest(), GetNewest());
+		Seek(generation);
+		T prototype = grid[0];
+		cells.resize(state.size());
+		for(size_t i = 0; i < state.size(); i++)
+		{
+			cells[i] = prototype.WithValue(state[i]);
+		}
+		grid.Load(cells);
+	}
+
+	int GetOldest() const
+	{
+		return first;
+	}
+
+	int GetNewest() const
+	{
+		return first + static_cast<int>(entries.size()) - 1;
+	}
+
+	int GetPosition() const
+	{
+		return stateGeneration;
+	}
+
+	//Encoded size of all stored generations
+	size_t GetBytes() const
+	{
+		return bytes;
+	}
+
+private:
+	struct Entry
+	{
+		bool keyframe;
+		std::vector<uint8_t> data;
+	};
+
+	std::deque<Entry> entries;
+	int first = 0;
+	size_t bytes = 0;
+	//Decoded states of the generation at stateGeneration, which is the current position
+	std::vector<uint8_t> state;
+	int stateGeneration = 0;
+	std::vector<uint8_t> nextState;
+	std::vector<T> cells;
+
+	Entry& At(int generation)
+	{
+		return entries[generation - first];
+	}
+
+	int LastKeyframe(int generation)
+	{
+		while(!At(generation).keyframe)
+		{
+			generation--;
+		}
+		return generation;
+	}
+
+	void Seek(int generation)
+	{
+		//Walk from the current position unless starting at a keyframe is closer
+		int keyframe = LastKeyframe(generation);
+		bool backwards = generation < stateGeneration && LastKeyframe(stateGeneration) <= generation;
+		bool forwards = generation >= stateGeneration && keyframe <= stateGeneration;
+		int distance = std::abs(generation - stateGeneration);
+		if(!(backwards || forwards) || generation - keyframe < distance)
+		{
+			DecodeKeyframe(At(keyframe).data, state);
+			stateGeneration = keyframe;
+		}
+		while(stateGeneration < generation)
+		{
+			stateGeneration++;
+			ApplyDelta(At(stateGeneration).data, state);
+		}
+		while(stateGeneration > generation)
+		{
+			ApplyDelta(At(stateGeneration).data, state);
+			stateGeneration--;
+		}
+	}
+
+	void DropAfter(int generation)
+	{
+		while(GetNewest() > generation)
+		{
+			bytes -= entries.back().data.size();
+			entries.pop_back();
+		}
+	}
+
+	//The second generation becomes the new first one, so it has to be turned into a keyframe if it is not one already
+	void DropFirst()
+	{
+		if(!entries[1].keyframe)
+		{
+			DecodeKeyframe(entries[0].data, nextState);
+			ApplyDelta(entries[1].data, nextState);
+			bytes -= entries[1].data.size();
+			entries[1] = Entry { true, EncodeKeyframe(nextState) };
+			bytes += entries[1].data.size();
+		}
+		bytes -= entries.front().data.size();
+		entries.pop_front();
+		first++;
+	}
+
+	static void ReadStates(const Grid3d<T>& grid, std::vector<uint8_t>& out)
+	{
+		out.resize(grid.GetCellCount());
+		for(size_t i = 0; i < out.size(); i++)
+		{
+			out[i] = static_cast<uint8_t>(static_cast<int>(grid[static_cast<int>(i)]));
+		}
+	}
+
+	static void WriteVarint(std::vector<uint8_t>& out, uint32_t value)
+	{
+		while(value >= 0x80)
+		{
+			out.push_back(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	static uint32_t ReadVarint(const std::vector<uint8_t>& in, size_t& pos)
+	{
+		uint32_t value = 0;
+		for(int shift = 0; ; shift += 7)
+		{
+			uint8_t b = in[pos++];
+			value |= static_cast<uint32_t>(b & 0x7F) << shift;
+			if((b & 0x80) == 0)
+			{
+				return value;
+			}
+		}
+	}
+
+	//Header with the cell count followed by (run length, state) pairs
+	static std::vector<uint8_t> EncodeKeyframe(const std::vector<uint8_t>& states)
+	{
+		std::vector<uint8_t> out;
+		WriteVarint(out, static_cast<uint32_t>(states.size()));
+		for(size_t i = 0; i < states.size();)
+		{
+			size_t run = 1;
+			while(i + run < states.size() && states[i + run] == states[i])
+			{
+				run++;
+			}
+			WriteVarint(out, static_cast<uint32_t>(run));
+			out.push_back(states[i]);
+			i += run;
+		}
+		out.shrink_to_fit();
+		return out;
+	}
+
+	static void DecodeKeyframe(const std::vector<uint8_t>& in, std::vector<uint8_t>& states)
+	{
+		size_t pos = 0;
+		states.resize(ReadVarint(in, pos));
+		auto it = states.begin();
+		while(pos < in.size())
+		{
+			uint32_t run = ReadVarint(in, pos);
+			uint8_t value = in[pos++];
+			it = std::fill_n(it, run, value);
+		}
+	}
+
+	//(distance to the previous changed cell, xor of both states) pairs
+	static std::vector<uint8_t> EncodeDelta(const std::vector<uint8_t>& from, const std::vector<uint8_t>& to)
+	{
+		std::vector<uint8_t> out;
+		size_t prev = 0;
+		for(size_t i = 0; i < to.size(); i++)
+		{
+			if(from[i] != to[i])
+			{
+				WriteVarint(out, static_cast<uint32_t>(i - prev));
+				out.push_back(from[i] ^ to[i]);
+				prev = i;
+			}
+		}
+		out.shrink_to_fit();
+		return out;
+	}
+
+	//Xor is its own inverse, so the same delta moves a generation forwards or backwards
+	static void ApplyDelta(const std::vector<uint8_t>& in, std::vector<uint8_t>& states)
+	{
+		size_t pos = 0;
+		size_t index = 0;
+		while(pos < in.size())
+		{
+			index += ReadVarint(in, pos);
+			states[index] ^= in[pos++];
+		}
+	}
+};
\ No newline at end of file
@@ -1,14 +1,12 @@
 #include "intcell.h"
 #include <algorithm>
 
-int IntCell::statesMinusOne = 0;
-
-IntCell::IntCell() : value(0)
+IntCell::IntCell() : value(0), statesMinusOne(1)
 {
 
 }
 
-IntCell::IntCell(int value) : value(value)
+IntCell::IntCell(int value, int statesMinusOne) : value(static_cast<uint8_t>(value)), statesMinusOne(static_cast<uint8_t>(statesMinusOne))
 {
 
 }
@@ -32,6 +30,11 @@ float IntCell::RenderGradient() const
     return (value - 1.0f) / (statesMinusOne - 1.0f);
 }
 
+IntCell IntCell::WithValue(int value) const
+{
+    return IntCell(value, statesMinusOne);
+}
+
 IntCell::operator int() const
 {
     return value;
@@ -1,20 +1,25 @@
 #pragma once
+#include <cstdint>
 #include "cell.h"
 
+//Cell with up to 256 states, where 0 is empty and statesMinusOne is alive
+//The amount of states is stored in each cell, so that simulations with different amounts of states can exist at the same time
 class IntCell : public Cell
 {
 public:
-	static int statesMinusOne;
-
 	IntCell();
-	IntCell(int value);
+	IntCell(int value, int statesMinusOne);
 
 	bool IsAlive() const override;
 	bool IsEmpty() const override;
 	float RenderGradient() const override;
 
+	//Cell with the same amount of states and a different value
+	IntCell WithValue(int value) const;
+
 	operator int() const;
 
 private:
-	int value = 0;
+	uint8_t value = 0;
+	uint8_t statesMinusOne = 1;
 };
\ No newline at end of file
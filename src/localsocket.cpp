@@ -0,0 +1,233 @@
+#include "localsocket.h"
+#include <format>
+#include <cstring>
+#include <utility>
+#include <filesystem>
+#include <algorithm>
+#include <climits>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+#ifdef _WIN32
+static const uintptr_t CLOSED = INVALID_SOCKET;
+
+static int LastError()
+{
+	return WSAGetLastError();
+}
+
+static bool WouldBlock()
+{
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+static void CloseSocket(uintptr_t handle)
+{
+	closesocket(handle);
+}
+#else
+static const int CLOSED = -1;
+
+static int LastError()
+{
+	return errno;
+}
+
+static bool WouldBlock()
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+static void CloseSocket(int handle)
+{
+	close(handle);
+}
+#endif
+
+LocalSocket::~LocalSocket()
+{
+	Close();
+}
+
+LocalSocket::LocalSocket(LocalSocket&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+LocalSocket& LocalSocket::operator=(LocalSocket&& other) noexcept
+{
+	if(this != &other)
+	{
+		Close();
+		handle = std::exchange(other.handle, CLOSED);
+		path = std::move(other.path);
+		error = std::move(other.error);
+		other.path.clear();
+	}
+	return *this;
+}
+
+bool LocalSocket::Listen(const std::string& path)
+{
+	Close();
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if(!Init() || path.size() >= sizeof(address.sun_path))
+	{
+		error = std::format("Can not listen on \"{0}\"", path);
+		return false;
+	}
+	std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+	std::error_code ignored;
+	std::filesystem::remove(path, ignored);
+
+	handle = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(handle == CLOSED || bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(handle, 16) != 0)
+	{
+		error = std::format("Can not listen on \"{0}\" (error {1})", path, LastError());
+		Close();
+		return false;
+	}
+	this->path = path;
+	return SetNonBlocking();
+}
+
+LocalSocket LocalSocket::Accept()
+{
+	LocalSocket client;
+	client.handle = accept(handle, nullptr, nullptr);
+	return client;
+}
+
+bool LocalSocket::Connect(const std::string& path)
+{
+	Close();
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if(!Init() || path.size() >= sizeof(address.sun_path))
+	{
+		error = std::format("Can not connect to \"{0}\"", path);
+		return false;
+	}
+	std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	handle = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(handle == CLOSED || connect(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		error = std::format("Can not connect to \"{0}\" (error {1})", path, LastError());
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void LocalSocket::Close()
+{
+	if(handle != CLOSED)
+	{
+		CloseSocket(handle);
+		handle = CLOSED;
+	}
+	if(!path.empty())
+	{
+		std::error_code ignored;
+		std::filesystem::remove(path, ignored);
+		path.clear();
+	}
+}
+
+void LocalSocket::Shutdown()
+{
+	if(handle != CLOSED)
+	{
+#ifdef _WIN32
+		shutdown(handle, SD_BOTH);
+#else
+		shutdown(handle, SHUT_RDWR);
+#endif
+	}
+}
+
+bool LocalSocket::IsOpen() const
+{
+	return handle != CLOSED;
+}
+
+const std::string& LocalSocket::GetError() const
+{
+	return error;
+}
+
+bool LocalSocket::SetNonBlocking()
+{
+#ifdef _WIN32
+	u_long enabled = 1;
+	bool success = ioctlsocket(handle, FIONBIO, &enabled) == 0;
+#else
+	bool success = fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+	if(!success)
+	{
+		error = std::format("Can not make the socket non blocking (error {0})", LastError());
+	}
+	return success;
+}
+
+int64_t LocalSocket::Send(const uint8_t* data, size_t size)
+{
+#ifdef _WIN32
+	int sent = send(handle, reinterpret_cast<const char*>(data), static_cast<int>(std::min<size_t>(size, INT_MAX)), 0);
+#else
+	//No SIGPIPE if the viewer is gone, the error is handled like any other
+	ssize_t sent = send(handle, data, size, MSG_NOSIGNAL);
+#endif
+	if(sent < 0)
+	{
+		return WouldBlock() ? 0 : -1;
+	}
+	return sent;
+}
+
+bool LocalSocket::Receive(uint8_t* data, size_t size)
+{
+	while(size > 0)
+	{
+#ifdef _WIN32
+		int received = recv(handle, reinterpret_cast<char*>(data), static_cast<int>(std::min<size_t>(size, INT_MAX)), 0);
+#else
+		ssize_t received = recv(handle, data, size, 0);
+#endif
+		if(received <= 0)
+		{
+			return false;
+		}
+		data += received;
+		size -= received;
+	}
+	return true;
+}
+
+bool LocalSocket::Init()
+{
+#ifdef _WIN32
+	static bool initialized = []()
+	{
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+	return initialized;
+#else
+	return true;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+//Stream socket in the local (Unix domain) address family, which both Linux and Windows 10 support
+//Only covers what the stream server and its viewers need, a listening socket and connected sockets that send and receive bytes
+class LocalSocket
+{
+public:
+	LocalSocket() = default;
+	~LocalSocket();
+
+	LocalSocket(const LocalSocket&) = delete;
+	LocalSocket& operator=(const LocalSocket&) = delete;
+	LocalSocket(LocalSocket&& other) noexcept;
+	LocalSocket& operator=(LocalSocket&& other) noexcept;
+
+	//Listens on the path, an existing socket file at the path is replaced
+	bool Listen(const std::string& path);
+	//Returns a closed socket if no client is waiting
+	LocalSocket Accept();
+	bool Connect(const std::string& path);
+	void Close();
+	//Ends the connection without closing the socket, wakes up a Receive that waits in another thread
+	void Shutdown();
+	bool IsOpen() const;
+	const std::string& GetError() const;
+
+	//Sends return right away instead of waiting for the receiver
+	bool SetNonBlocking();
+	//Amount of bytes that were sent (0 if the socket would block) or -1 if the connection is broken
+	int64_t Send(const uint8_t* data, size_t size);
+	//Waits until all bytes were received, false if the connection was closed
+	bool Receive(uint8_t* data, size_t size);
+
+private:
+#ifdef _WIN32
+	uintptr_t handle = ~static_cast<uintptr_t>(0);
+#else
+	int handle = -1;
+#endif
+	//Path of a listening socket, which is removed when it is closed
+	std::string path;
+	std::string error;
+
+	static bool Init();
+};
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "mappedfile.h"
+#include <format>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <cerrno>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& path, uint64_t size)
+{
+	Close();
+	file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, size != 0 ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		file = nullptr;
+		error = std::format("Could not open \"{0}\" (error {1})", path, GetLastError());
+		return false;
+	}
+	if(size != 0)
+	{
+		LARGE_INTEGER end;
+		end.QuadPart = static_cast<LONGLONG>(size);
+		if(!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+		{
+			error = std::format("Could not resize \"{0}\" to {1} bytes (error {2})", path, size, GetLastError());
+			Close();
+			return false;
+		}
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	this->size = static_cast<uint64_t>(fileSize.QuadPart);
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+	if(mapping == nullptr)
+	{
+		error = std::format("Could not map \"{0}\" (error {1})", path, GetLastError());
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(mapping != nullptr)
+	{
+		CloseHandle(mapping);
+		mapping = nullptr;
+	}
+	if(file != nullptr)
+	{
+		CloseHandle(file);
+		file = nullptr;
+	}
+	size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return mapping != nullptr;
+}
+
+MappedFile::View MappedFile::Map(uint64_t offset, uint64_t size)
+{
+	View view;
+	uint64_t base = offset - (offset % Granularity());
+	view.baseSize = size + (offset - base);
+	view.base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, static_cast<DWORD>(base >> 32), static_cast<DWORD>(base & 0xFFFFFFFF), static_cast<SIZE_T>(view.baseSize));
+	if(view.base == nullptr)
+	{
+		error = std::format("Could not map {0} bytes at {1} (error {2})", size, offset, GetLastError());
+		return View();
+	}
+	view.data = static_cast<uint8_t*>(view.base) + (offset - base);
+	view.offset = offset;
+	view.size = size;
+	return view;
+}
+
+void MappedFile::Unmap(View& view)
+{
+	if(view.base != nullptr)
+	{
+		UnmapViewOfFile(view.base);
+	}
+	view = View();
+}
+
+void MappedFile::Flush(const View& view)
+{
+	if(view.base != nullptr)
+	{
+		FlushViewOfFile(view.base, static_cast<SIZE_T>(view.baseSize));
+	}
+}
+
+uint64_t MappedFile::Granularity()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwAllocationGranularity;
+}
+#else
+bool MappedFile::Open(const std::string& path, uint64_t size)
+{
+	Close();
+	file = open(path.c_str(), size != 0 ? O_RDWR | O_CREAT : O_RDWR, 0644);
+	if(file < 0)
+	{
+		error = std::format("Could not open \"{0}\" ({1})", path, std::strerror(errno));
+		return false;
+	}
+	if(size != 0 && ftruncate(file, static_cast<off_t>(size)) != 0)
+	{
+		error = std::format("Could not resize \"{0}\" to {1} bytes ({2})", path, size, std::strerror(errno));
+		Close();
+		return false;
+	}
+	struct stat info;
+	fstat(file, &info);
+	this->size = static_cast<uint64_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(file >= 0)
+	{
+		close(file);
+		file = -1;
+	}
+	size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return file >= 0;
+}
+
+MappedFile::View MappedFile::Map(uint64_t offset, uint64_t size)
+{
+	View view;
+	uint64_t base = offset - (offset % Granularity());
+	view.baseSize = size + (offset - base);
+	void* p = mmap(nullptr, static_cast<size_t>(view.baseSize), PROT_READ | PROT_WRITE, MAP_SHARED, file, static_cast<off_t>(base));
+	if(p == MAP_FAILED)
+	{
+		error = std::format("Could not map {0} bytes at {1} ({2})", size, offset, std::strerror(errno));
+		return View();
+	}
+	view.base = p;
+	view.data = static_cast<uint8_t*>(p) + (offset - base);
+	view.offset = offset;
+	view.size = size;
+	return view;
+}
+
+void MappedFile::Unmap(View& view)
+{
+	if(view.base != nullptr)
+	{
+		munmap(view.base, static_cast<size_t>(view.baseSize));
+	}
+	view = View();
+}
+
+void MappedFile::Flush(const View& view)
+{
+	if(view.base != nullptr)
+	{
+		msync(view.base, static_cast<size_t>(view.baseSize), MS_SYNC);
+	}
+}
+
+uint64_t MappedFile::Granularity()
+{
+	return static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+#endif
+
+uint64_t MappedFile::GetSize() const
+{
+	return size;
+}
+
+const std::string& MappedFile::GetError() const
+{
+	return error;
+}
\ No newline at end of file
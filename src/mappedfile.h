@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+//File that is accessed through memory mapped views, so that files larger than the available memory can be processed piece by piece
+//Only the views that are currently mapped need to be resident, the operating system writes changed pages back to the file
+class MappedFile
+{
+public:
+	//Mapped range of the file, data points to the requested offset
+	struct View
+	{
+		uint8_t* data = nullptr;
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		void* base = nullptr;
+		uint64_t baseSize = 0;
+	};
+
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//Opens an existing file, or creates it with the given size if size is not 0 (an existing file is resized)
+	bool Open(const std::string& path, uint64_t size);
+	void Close();
+	bool IsOpen() const;
+	uint64_t GetSize() const;
+	const std::string& GetError() const;
+
+	//Maps [offset, offset + size) of the file, the offset does not have to be aligned
+	View Map(uint64_t offset, uint64_t size);
+	void Unmap(View& view);
+	//Writes the changed pages of the view back to the file
+	void Flush(const View& view);
+
+private:
+	std::string error;
+	uint64_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#else
+	int file = -1;
+#endif
+
+	static uint64_t Granularity();
+};
\ No newline at end of file
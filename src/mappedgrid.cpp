@@ -0,0 +1,301 @@
+#include "mappedgrid.h"
+#include <random>
+#include <cstring>
+#include <algorithm>
+
+#include "simulation.h"
+#include "magic_enum.hpp"
+
+MappedGrid::~MappedGrid()
+{
+	CloseWindow();
+}
+
+bool MappedGrid::Create(const std::string& path, const StaticSimSettings& settings, uint32_t seed)
+{
+	if(!CreateEmpty(path, settings))
+	{
+		return false;
+	}
+
+	//Same shape, probability and order of the random numbers as Simulation::Fill, so the same seed gives the same cells, plane by plane so that only a part of the file is touched at once
+	std::default_random_engine randEngine(seed);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	uint8_t alive = static_cast<uint8_t>(settings.states - 1);
+	uint64_t population = 0;
+	for(int z = 0; z < dimSize; z++)
+	{
+		uint8_t* plane = Plane(z);
+		for(int y = 0; y < dimSize; y++)
+		{
+			for(int x = 0; x < dimSize; x++)
+			{
+				bool set = Simulation::IsInFill(settings, x, y, z) && distribution(randEngine) < settings.fillProb;
+				plane[(y * dimSize) + x] = set ? alive : 0;
+				population += set ? 1 : 0;
+			}
+		}
+	}
+	header->population = population;
+	header->alive = population;
+	header->changed = population;
+	return true;
+}
+
+bool MappedGrid::Create(const std::string& path, const StaticSimSettings& settings, uint64_t generation, const uint8_t* cells)
+{
+	if(!CreateEmpty(path, settings))
+	{
+		return false;
+	}
+
+	uint8_t alive = static_cast<uint8_t>(settings.states - 1);
+	for(int z = 0; z < dimSize; z++)
+	{
+		const uint8_t* plane = cells + (z * planeSize);
+		std::memcpy(Plane(z), plane, planeSize);
+		for(uint64_t i = 0; i < planeSize; i++)
+		{
+			header->population += plane[i] != 0;
+			header->alive += plane[i] == alive;
+		}
+	}
+	header->generation = generation;
+	return true;
+}
+
+bool MappedGrid::Open(const std::string& path)
+{
+	CloseWindow();
+	if(!file.Open(path, 0))
+	{
+		error = file.GetError();
+		return false;
+	}
+	if(file.GetSize() < HEADER_SIZE)
+	{
+		error = "File is too small for a grid";
+		file.Close();
+		return false;
+	}
+
+	MappedFile::View view = file.Map(0, sizeof(Header));
+	if(view.data == nullptr)
+	{
+		error = file.GetError();
+		file.Close();
+		return false;
+	}
+	Header loaded;
+	std::memcpy(&loaded, view.data, sizeof(Header));
+	file.Unmap(view);
+
+	uint64_t cells = static_cast<uint64_t>(loaded.dimSize) * loaded.dimSize * loaded.dimSize;
+	if(std::memcmp(loaded.magic, MAGIC, sizeof(MAGIC)) != 0 || loaded.version != VERSION || file.GetSize() < HEADER_SIZE + cells || loaded.states < 2 || !magic_enum::enum_contains<NeighbourMode>(loaded.neighbourMode))
+	{
+		error = "File is not a grid written by this version";
+		file.Close();
+		return false;
+	}
+
+	settings = StaticSimSettings();
+	settings.size = { static_cast<int>(loaded.dimSize), static_cast<int>(loaded.dimSize), static_cast<int>(loaded.dimSize) };
+	settings.states = loaded.states;
+	settings.neighbourMode = static_cast<NeighbourMode>(loaded.neighbourMode);
+	settings.wrap.fill(loaded.wrapSide != 0);
+	for(int i = 0; i < 64; i++)
+	{
+		settings.surviveRule.Set(i, (loaded.surviveRule >> i) & 1);
+		settings.spawnRule.Set(i, (loaded.spawnRule >> i) & 1);
+	}
+	return Init();
+}
+
+void MappedGrid::Flush()
+{
+	for(Slab& slab : slabs)
+	{
+		file.Flush(slab.view);
+	}
+	file.Flush(headerView);
+}
+
+void MappedGrid::Step()
+{
+	int n = dimSize;
+	bool wrap = settings.wrap[0];
+	ReadPlane(wrap ? n - 1 : -1, output);
+	kernel.Begin(wrap ? output.data() : nullptr, Plane(0));
+	if(wrap)
+	{
+		ReadPlane(0, first);
+	}
+
+	//The kernel keeps copies of the planes around z, so each plane can be overwritten right after it was computed
+	PlaneKernel::Stats stats;
+	for(int z = 0; z < n; z++)
+	{
+		const uint8_t* next = z + 1 < n ? Plane(z + 1) : (wrap ? first.data() : nullptr);
+		kernel.Next(next, output.data(), stats);
+		std::memcpy(Plane(z), output.data(), planeSize);
+	}
+
+	header->generation++;
+	header->changed = stats.changed;
+	header->population = stats.population;
+	header->alive = stats.alive;
+}
+
+int MappedGrid::GetDimSize() const
+{
+	return dimSize;
+}
+
+uint64_t MappedGrid::GetCellCount() const
+{
+	return planeSize * dimSize;
+}
+
+const StaticSimSettings& MappedGrid::GetSettings() const
+{
+	return settings;
+}
+
+uint64_t MappedGrid::GetGeneration() const
+{
+	return header != nullptr ? header->generation : 0;
+}
+
+uint64_t MappedGrid::GetPopulation() const
+{
+	return header != nullptr ? header->population : 0;
+}
+
+uint64_t MappedGrid::GetAliveCount() const
+{
+	return header != nullptr ? header->alive : 0;
+}
+
+uint64_t MappedGrid::GetChangedCount() const
+{
+	return header != nullptr ? header->changed : 0;
+}
+
+uint64_t MappedGrid::GetWindowBytes() const
+{
+	//Mapped slabs plus the plane buffers used by Step
+	return (static_cast<uint64_t>(MAPPED_WINDOW_SLABS) * planesPerSlab * planeSize) + (10 * planeSize);
+}
+
+const std::string& MappedGrid::GetError() const
+{
+	return error;
+}
+
+uint8_t MappedGrid::GetCell(int x, int y, int z)
+{
+	return Plane(z)[(static_cast<uint64_t>(y) * dimSize) + x];
+}
+
+bool MappedGrid::CreateEmpty(const std::string& path, const StaticSimSettings& settings)
+{
+	CloseWindow();
+	this->settings = settings;
+	uint64_t cells = static_cast<uint64_t>(settings.size[0]) * settings.size[0] * settings.size[0];
+	if(!file.Open(path, HEADER_SIZE + cells))
+	{
+		error = file.GetError();
+		return false;
+	}
+	if(!Init())
+	{
+		return false;
+	}
+
+	std::memset(header, 0, sizeof(Header));
+	std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+	header->version = VERSION;
+	header->dimSize = settings.size[0];
+	header->states = settings.states;
+	header->neighbourMode = settings.neighbourMode;
+	header->wrapSide = settings.wrap[0] ? 1 : 0;
+	header->surviveRule = settings.surviveRule;
+	header->spawnRule = settings.spawnRule;
+	return true;
+}
+
+bool MappedGrid::Init()
+{
+	dimSize = settings.size[0];
+	planeSize = static_cast<uint64_t>(dimSize) * dimSize;
+	planesPerSlab = static_cast<int>(std::clamp<uint64_t>(MAPPED_SLAB_BYTES / planeSize, 1, dimSize));
+
+	headerView = file.Map(0, sizeof(Header));
+	if(headerView.data == nullptr)
+	{
+		error = file.GetError();
+		file.Close();
+		return false;
+	}
+	header = reinterpret_cast<Header*>(headerView.data);
+
+	kernel = PlaneKernel(settings);
+	first = std::vector<uint8_t>(planeSize);
+	output = std::vector<uint8_t>(planeSize);
+	return true;
+}
+
+void MappedGrid::CloseWindow()
+{
+	for(Slab& slab : slabs)
+	{
+		file.Unmap(slab.view);
+		slab.index = -1;
+	}
+	file.Unmap(headerView);
+	header = nullptr;
+	file.Close();
+}
+
+uint8_t* MappedGrid::Plane(int z)
+{
+	int index = z / planesPerSlab;
+	Slab* target = nullptr;
+	for(Slab& slab : slabs)
+	{
+		if(slab.index == index)
+		{
+			target = &slab;
+			break;
+		}
+	}
+
+	//Replace the least recently used slab, while stepping that is the one behind the current plane
+	if(target == nullptr)
+	{
+		target = &*std::min_element(std::begin(slabs), std::end(slabs), [](const Slab& a, const Slab& b) { return a.lastUse < b.lastUse; });
+		file.Unmap(target->view);
+		int firstPlane = index * planesPerSlab;
+		int planeCount = std::min(planesPerSlab, dimSize - firstPlane);
+		target->view = file.Map(HEADER_SIZE + (firstPlane * planeSize), planeCount * planeSize);
+		target->index = index;
+		if(target->view.data == nullptr)
+		{
+			target->index = -1;
+			error = file.GetError();
+			throw std::exception(error.c_str());
+		}
+	}
+	target->lastUse = ++useCounter;
+	return target->view.data + ((z - (index * planesPerSlab)) * planeSize);
+}
+
+void MappedGrid::ReadPlane(int z, std::vector<uint8_t>& out)
+{
+	if(z < 0)
+	{
+		std::fill(out.begin(), out.end(), 0);
+		return;
+	}
+	std::memcpy(out.data(), Plane(z), planeSize);
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "config.h"
+#include "mappedfile.h"
+#include "planekernel.h"
+
+//Grid with one byte per cell (0 = empty, states - 1 = alive) that lives in a memory mapped file instead of memory, for grids that do not fit into memory
+//The cells are stored plane by plane along z after a header with the settings and statistics, so the file is also a snapshot that can be opened again to continue
+//Step() streams the planes through a window of MAPPED_WINDOW_SLABS mapped slabs and a few planes in memory, all indices are 64 bit
+//Mapped grids are cubes (settings.size[0] cells along each axis) that wrap around along all axes or none (settings.wrap[0])
+class MappedGrid
+{
+public:
+	MappedGrid() = default;
+	~MappedGrid();
+
+	MappedGrid(const MappedGrid&) = delete;
+	MappedGrid& operator=(const MappedGrid&) = delete;
+
+	//Creates the file and fills the initial cells like Simulation does
+	bool Create(const std::string& path, const StaticSimSettings& settings, uint32_t seed);
+	//Creates the file from existing cells (dimSize^3, plane by plane along z), e.g. a snapshot of a sharded simulation
+	bool Create(const std::string& path, const StaticSimSettings& settings, uint64_t generation, const uint8_t* cells);
+	//Opens a file written by Create (and any amount of steps) to continue from there
+	bool Open(const std::string& path);
+	//Writes all changes back to the file
+	void Flush();
+
+	//Simulates a single step in place, only the planes around the current one have to be resident
+	void Step();
+
+	int GetDimSize() const;
+	uint64_t GetCellCount() const;
+	const StaticSimSettings& GetSettings() const;
+	uint64_t GetGeneration() const;
+	//Amount of non empty cells
+	uint64_t GetPopulation() const;
+	uint64_t GetAliveCount() const;
+	//Amount of cells that changed in the last step
+	uint64_t GetChangedCount() const;
+	//Upper bound of the memory that is mapped or allocated at once while stepping
+	uint64_t GetWindowBytes() const;
+	const std::string& GetError() const;
+
+	uint8_t GetCell(int x, int y, int z);
+
+private:
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t dimSize;
+		uint32_t states;
+		uint32_t neighbourMode;
+		uint32_t wrapSide;
+		uint32_t reserved;
+		uint64_t surviveRule;
+		uint64_t spawnRule;
+		uint64_t generation;
+		uint64_t population;
+		uint64_t alive;
+		uint64_t changed;
+	};
+
+	struct Slab
+	{
+		MappedFile::View view;
+		int index = -1;
+		uint64_t lastUse = 0;
+	};
+
+	static const uint64_t HEADER_SIZE = 4096;
+	static constexpr char MAGIC[8] = { 'C', 'A', '3', 'D', 'G', 'R', 'I', 'D' };
+	static const uint32_t VERSION = 1;
+
+	MappedFile file;
+	MappedFile::View headerView;
+	Header* header = nullptr;
+	StaticSimSettings settings = {};
+	int dimSize = 0;
+	uint64_t planeSize = 0;
+	int planesPerSlab = 1;
+	Slab slabs[MAPPED_WINDOW_SLABS];
+	uint64_t useCounter = 0;
+	std::string error;
+
+	PlaneKernel kernel;
+	//Copy of the first plane, which is needed again for the last one when wrapping
+	std::vector<uint8_t> first;
+	std::vector<uint8_t> output;
+
+	bool CreateEmpty(const std::string& path, const StaticSimSettings& settings);
+	bool Init();
+	void CloseWindow();
+	uint8_t* Plane(int z);
+	void ReadPlane(int z, std::vector<uint8_t>& out);
+};
\ No newline at end of file
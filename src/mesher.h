@@ -0,0 +1,129 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "config.h"
+#include "cellbatch.h"
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+namespace Mesher
+{
+	static uint32_t PackColor(const raylib::Color& c)
+	{
+		return (static_cast<uint32_t>(c.r) << 24) | (static_cast<uint32_t>(c.g) << 16) | (static_cast<uint32_t>(c.b) << 8) | c.a;
+	}
+
+	static raylib::Color UnpackColor(uint32_t c)
+	{
+		return raylib::Color { static_cast<unsigned char>(c >> 24), static_cast<unsigned char>(c >> 16), static_cast<unsigned char>(c >> 8), static_cast<unsigned char>(c) };
+	}
+
+	//Appends the surface of all non empty cells (alpha > 0) in the box [from, to) of a color volume with the given size to out
+	//Only faces between non empty and empty cells are emitted and coplanar faces of the same color are merged into larger quads
+	//Cell (x, y, z) covers [offset + (x, y, z) * cellSize, offset + (x + 1, y + 1, z + 1) * cellSize)
+	static void BuildGreedy(const std::vector<raylib::Color>& volume, const Extent& size, const int from[3], const int to[3], float cellSize, const raylib::Vector3& offset, CellBatch& out)
+	{
+		const float offsets[3] = { offset.x, offset.y, offset.z };
+		auto colorAt = [&](const int p[3]) -> uint32_t
+		{
+			if(p[0] < 0 || p[0] >= size[0] || p[1] < 0 || p[1] >= size[1] || p[2] < 0 || p[2] >= size[2])
+			{
+				return 0;
+			}
+			const raylib::Color& c = volume[(p[2] * size[0] * size[1]) + (p[1] * size[0]) + p[0]];
+			return c.a != 0 ? PackColor(c) : 0;
+		};
+
+		std::vector<uint32_t> mask;
+		for(int d = 0; d < 3; d++)
+		{
+			int u = (d + 1) % 3;
+			int v = (d + 2) % 3;
+			int sizeU = to[u] - from[u];
+			int sizeV = to[v] - from[v];
+			mask.resize(sizeU * sizeV);
+
+			for(int dir = -1; dir <= 1; dir += 2)
+			{
+				for(int k = from[d]; k < to[d]; k++)
+				{
+					//Mask of visible faces in this slice
+					int p[3];
+					int n[3];
+					p[d] = k;
+					n[d] = k + dir;
+					for(int j = 0; j < sizeV; j++)
+					{
+						p[v] = n[v] = from[v] + j;
+						for(int i = 0; i < sizeU; i++)
+						{
+							p[u] = n[u] = from[u] + i;
+							uint32_t c = colorAt(p);
+							mask[j * sizeU + i] = (c != 0 && colorAt(n) == 0) ? c : 0;
+						}
+					}
+
+					//Merge equal faces into rectangles, first along u and then along v
+					float plane = offsets[d] + (k + (dir > 0 ? 1 : 0)) * cellSize;
+					for(int j = 0; j < sizeV; j++)
+					{
+						for(int i = 0; i < sizeU;)
+						{
+							uint32_t c = mask[j * sizeU + i];
+							if(c == 0)
+							{
+								i++;
+								continue;
+							}
+
+							int w = 1;
+							while(i + w < sizeU && mask[j * sizeU + i + w] == c)
+							{
+								w++;
+							}
+							int h = 1;
+							while(j + h < sizeV && std::all_of(&mask[(j + h) * sizeU + i], &mask[(j + h) * sizeU + i + w], [c](uint32_t m) { return m == c; }))
+							{
+								h++;
+							}
+							for(int l = j; l < j + h; l++)
+							{
+								std::fill(&mask[l * sizeU + i], &mask[l * sizeU + i + w], 0);
+							}
+
+							float q0[3];
+							q0[d] = plane;
+							q0[u] = offsets[u] + (from[u] + i) * cellSize;
+							q0[v] = offsets[v] + (from[v] + j) * cellSize;
+							float du = w * cellSize;
+							float dv = h * cellSize;
+							float q1[3] = { q0[0], q0[1], q0[2] };
+							q1[u] += du;
+							float q2[3] = { q1[0], q1[1], q1[2] };
+							q2[v] += dv;
+							float q3[3] = { q0[0], q0[1], q0[2] };
+							q3[v] += dv;
+
+							//u x v points along +d, so the winding is flipped for faces pointing along -d
+							raylib::Vector3 a = { q0[0], q0[1], q0[2] };
+							raylib::Vector3 b = { q1[0], q1[1], q1[2] };
+							raylib::Vector3 e = { q2[0], q2[1], q2[2] };
+							raylib::Vector3 f = { q3[0], q3[1], q3[2] };
+							if(dir > 0)
+							{
+								out.AppendQuad(a, b, e, f, UnpackColor(c));
+							}
+							else
+							{
+								out.AppendQuad(a, f, e, b, UnpackColor(c));
+							}
+							i += w;
+						}
+					}
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#pragma once
+#include <array>
+#include <utility>
+#include <type_traits>
+#include <exception>
+
+#include "config.h"
+#include "magic_enum.hpp"
+
+//Neighbourhoods of a cell, each defined at compile time as the set of offsets within the 3x3x3 cube around the cell for which Contains is true
+//The kernels that count neighbours are instantiated once per neighbourhood (see Visit), so their loops over the offsets are unrolled with constant offsets
+//A new neighbourhood only needs a value in NeighbourMode and a Definition, the UI, the rule parser and the symmetries are derived from it (see Get)
+namespace Neighbourhood
+{
+	using Offset = std::array<int, 3>;
+
+	//Amount of axes along which an offset leaves the cell: 1 for faces, 2 for edges and 3 for corners
+	constexpr int Axes(int dx, int dy, int dz)
+	{
+		return (dx != 0 ? 1 : 0) + (dy != 0 ? 1 : 0) + (dz != 0 ? 1 : 0);
+	}
+
+	template<NeighbourMode M>
+	struct Definition;
+
+	template<>
+	struct Definition<NeighbourMode::Moore>
+	{
+		static constexpr const char* NAME = "Moore (26)";
+		static constexpr const char* LABEL = "M";
+		static constexpr bool Contains(int, int, int) { return true; }
+	};
+
+	template<>
+	struct Definition<NeighbourMode::VonNeumann>
+	{
+		static constexpr const char* NAME = "Von Neumann (6)";
+		static constexpr const char* LABEL = "VN";
+		static constexpr bool Contains(int dx, int dy, int dz) { return Axes(dx, dy, dz) == 1; }
+	};
+
+	//Faces and edges, Moore without the corners
+	template<>
+	struct Definition<NeighbourMode::FaceEdge>
+	{
+		static constexpr const char* NAME = "Face Edge (18)";
+		static constexpr const char* LABEL = "FE";
+		static constexpr bool Contains(int dx, int dy, int dz) { return Axes(dx, dy, dz) <= 2; }
+	};
+
+	template<>
+	struct Definition<NeighbourMode::Corners>
+	{
+		static constexpr const char* NAME = "Corners (8)";
+		static constexpr const char* LABEL = "C";
+		static constexpr bool Contains(int dx, int dy, int dz) { return Axes(dx, dy, dz) == 3; }
+	};
+
+	//Directional, only the 9 cells of the plane below (-y), so structures grow upwards
+	template<>
+	struct Definition<NeighbourMode::Below>
+	{
+		static constexpr const char* NAME = "Below (9)";
+		static constexpr const char* LABEL = "B";
+		static constexpr bool Contains(int, int dy, int) { return dy == -1; }
+	};
+
+	//Offsets of a definition and the properties derived from them
+	template<NeighbourMode M>
+	struct Stencil
+	{
+		static constexpr NeighbourMode MODE = M;
+		static constexpr const char* NAME = Definition<M>::NAME;
+		static constexpr const char* LABEL = Definition<M>::LABEL;
+
+		static constexpr int COUNT = []()
+		{
+			int count = 0;
+			for(int dz = -1; dz <= 1; dz++)
+			{
+				for(int dy = -1; dy <= 1; dy++)
+				{
+					for(int dx = -1; dx <= 1; dx++)
+					{
+						count += (dx != 0 || dy != 0 || dz != 0) && Definition<M>::Contains(dx, dy, dz) ? 1 : 0;
+					}
+				}
+			}
+			return count;
+		}();
+		static_assert(COUNT > 0, "A neighbourhood needs at least one neighbour");
+
+		//Ordered along x first, then y and then z, so the offsets in the cell data are ascending
+		static constexpr std::array<Offset, COUNT> OFFSETS = []()
+		{
+			std::array<Offset, COUNT> offsets = {};
+			int n = 0;
+			for(int dz = -1; dz <= 1; dz++)
+			{
+				for(int dy = -1; dy <= 1; dy++)
+				{
+					for(int dx = -1; dx <= 1; dx++)
+					{
+						if((dx != 0 || dy != 0 || dz != 0) && Definition<M>::Contains(dx, dy, dz))
+						{
+							offsets[n++] = Offset { dx, dy, dz };
+						}
+					}
+				}
+			}
+			return offsets;
+		}();
+
+		//Whether map(offset) is in the set for every offset in it
+		template<typename F>
+		static constexpr bool Invariant(F map)
+		{
+			for(const Offset& o : OFFSETS)
+			{
+				Offset m = map(o);
+				if(!Definition<M>::Contains(m[0], m[1], m[2]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//Whether the set is invariant under the reflection along each axis, and under all permutations of the axes
+		static constexpr std::array<bool, 3> MIRROR = { Invariant([](Offset o) { o[0] = -o[0]; return o; }), Invariant([](Offset o) { o[1] = -o[1]; return o; }), Invariant([](Offset o) { o[2] = -o[2]; return o; }) };
+		static constexpr bool PERMUTE = Invariant([](Offset o) { std::swap(o[0], o[1]); return o; }) && Invariant([](Offset o) { std::swap(o[1], o[2]); return o; });
+		//Whether any neighbour only shares an edge or a corner with the cell
+		static constexpr bool DIAGONAL = []()
+		{
+			for(const Offset& o : OFFSETS)
+			{
+				if(Axes(o[0], o[1], o[2]) > 1)
+				{
+					return true;
+				}
+			}
+			return false;
+		}();
+
+		//Calls func(offset) for every offset, unrolled at compile time
+		template<typename F>
+		static void ForEach(F&& func)
+		{
+			[&]<int... I>(std::integer_sequence<int, I...>)
+			{
+				(func(OFFSETS[I]), ...);
+			}(std::make_integer_sequence<int, COUNT>());
+		}
+
+		//Distance of the cell at the offset in cell data that is stored along x first, then y and then z
+		static constexpr int Flat(const Offset& offset, int rowSize, int planeSize)
+		{
+			return offset[0] + (offset[1] * rowSize) + (offset[2] * planeSize);
+		}
+	};
+
+	//Calls func(Stencil<mode>()) with the stencil of a mode that is only known at runtime, so func is instantiated for every neighbourhood
+	template<size_t I = 0, typename F>
+	decltype(auto) Visit(NeighbourMode mode, F&& func)
+	{
+		constexpr NeighbourMode m = magic_enum::enum_value<NeighbourMode>(I);
+		if constexpr(I + 1 < magic_enum::enum_count<NeighbourMode>())
+		{
+			if(mode != m)
+			{
+				return Visit<I + 1>(mode, std::forward<F>(func));
+			}
+		}
+		else if(mode != m)
+		{
+			throw std::exception("Missing definition in Neighbourhood::Visit!");
+		}
+		return func(Stencil<m>());
+	}
+
+	struct Info
+	{
+		const char* name;
+		//Short name for the preset buttons
+		const char* label;
+		int count;
+		bool mirror[3];
+		bool permute;
+		bool diagonal;
+	};
+
+	//Properties of the stencil of a mode, for code that does not need the offsets
+	inline const Info& Get(NeighbourMode mode)
+	{
+		return Visit(mode, [](auto stencil) -> const Info&
+		{
+			using S = decltype(stencil);
+			static const Info info = { S::NAME, S::LABEL, S::COUNT, { S::MIRROR[0], S::MIRROR[1], S::MIRROR[2] }, S::PERMUTE, S::DIAGONAL };
+			return info;
+		});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+
+#include "config.h"
+
+//One bit per cell (set = non empty), stored as rows along x with 64 cells per word
+//Additionally keeps the amount of set bits per row, so that empty and completely filled rows can be skipped without looking at the bits
+class OccupancyMask
+{
+public:
+	OccupancyMask() = default;
+
+	OccupancyMask(const Extent& size) : size(size), wordsPerRow((size[0] + 63) / 64)
+	{
+		bits = std::vector<uint64_t>(size[1] * size[2] * wordsPerRow, 0);
+		rowCounts = std::vector<int>(size[1] * size[2], 0);
+	}
+
+	const Extent& GetSize() const
+	{
+		return size;
+	}
+
+	int GetWordsPerRow() const
+	{
+		return wordsPerRow;
+	}
+
+	bool Get(int x, int y, int z) const
+	{
+		return (Row(y, z)[x >> 6] >> (x & 63)) & 1;
+	}
+
+	//Not thread safe across cells of the same row
+	void Set(int x, int y, int z, bool value)
+	{
+		uint64_t& word = bits[(RowIndex(y, z) * wordsPerRow) + (x >> 6)];
+		uint64_t bit = static_cast<uint64_t>(1) << (x & 63);
+		if(((word & bit) != 0) != value)
+		{
+			word ^= bit;
+			rowCounts[RowIndex(y, z)] += value ? 1 : -1;
+		}
+	}
+
+	const uint64_t* Row(int y, int z) const
+	{
+		return &bits[RowIndex(y, z) * wordsPerRow];
+	}
+
+	int RowCount(int y, int z) const
+	{
+		return rowCounts[RowIndex(y, z)];
+	}
+
+	//Writes the bits of all cells in the row that are set and not enclosed by 6 set face neighbours to out (wordsPerRow words)
+	//Cells on the border of the grid are never enclosed
+	void VisibleRow(int y, int z, uint64_t* out) const
+	{
+		const uint64_t* row = Row(y, z);
+		if(RowCount(y, z) == 0 || y == 0 || z == 0 || y == size[1] - 1 || z == size[2] - 1)
+		{
+			std::copy(row, row + wordsPerRow, out);
+			return;
+		}
+
+		//Inside of a solid region only the two end cells of the row can be seen
+		int rowLength = size[0];
+		if(RowCount(y, z) == rowLength && RowCount(y - 1, z) == rowLength && RowCount(y + 1, z) == rowLength && RowCount(y, z - 1) == rowLength && RowCount(y, z + 1) == rowLength)
+		{
+			std::fill(out, out + wordsPerRow, 0);
+			out[0] |= 1;
+			out[(rowLength - 1) >> 6] |= static_cast<uint64_t>(1) << ((rowLength - 1) & 63);
+			return;
+		}
+
+		const uint64_t* neighbourRows[4] = { Row(y - 1, z), Row(y + 1, z), Row(y, z - 1), Row(y, z + 1) };
+		for(int w = 0; w < wordsPerRow; w++)
+		{
+			uint64_t left = (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+			uint64_t right = (row[w] >> 1) | (w < wordsPerRow - 1 ? row[w + 1] << 63 : 0);
+			uint64_t enclosed = row[w] & left & right;
+			for(const uint64_t* n : neighbourRows)
+			{
+				enclosed &= n[w];
+			}
+			out[w] = row[w] & ~enclosed;
+		}
+	}
+
+	//Calls func(x) for every set bit in a row of wordsPerRow words
+	template<typename F>
+	static void ForEachBit(const uint64_t* row, int wordsPerRow, F func)
+	{
+		for(int w = 0; w < wordsPerRow; w++)
+		{
+			uint64_t word = row[w];
+			while(word != 0)
+			{
+				func((w << 6) + std::countr_zero(word));
+				word &= word - 1;
+			}
+		}
+	}
+
+private:
+	Extent size = {};
+	int wordsPerRow = 0;
+	std::vector<uint64_t> bits;
+	std::vector<int> rowCounts;
+
+	int RowIndex(int y, int z) const
+	{
+		return (z * size[1]) + y;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,214 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+namespace Parallel
+{
+	static int ThreadCount()
+	{
+		return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	//Fixed set of worker threads that run submitted tasks in order
+	class ThreadPool
+	{
+	public:
+		ThreadPool(int threadCount) : workerTasks(threadCount)
+		{
+			for(int i = 0; i < threadCount; i++)
+			{
+				workers.emplace_back(&ThreadPool::Work, this, i);
+			}
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			taskAdded.notify_all();
+			for(std::thread& worker : workers)
+			{
+				worker.join();
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		int GetThreadCount() const
+		{
+			return static_cast<int>(workers.size());
+		}
+
+		void Submit(std::function<void()> task)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.push_back(std::move(task));
+			}
+			taskAdded.notify_one();
+		}
+
+		//Runs the task on a specific worker, which takes these tasks before the shared ones
+		void SubmitTo(int worker, std::function<void()> task)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				workerTasks[worker].push_back(std::move(task));
+			}
+			taskAdded.notify_all();
+		}
+
+	private:
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> tasks;
+		std::vector<std::deque<std::function<void()>>> workerTasks;
+		std::mutex mutex;
+		std::condition_variable taskAdded;
+		bool stopping = false;
+
+		void Work(int index)
+		{
+			std::deque<std::function<void()>>& own = workerTasks[index];
+			while(true)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					taskAdded.wait(lock, [&]() { return stopping || !tasks.empty() || !own.empty(); });
+					std::deque<std::function<void()>>& queue = !own.empty() ? own : tasks;
+					if(queue.empty())
+					{
+						return;
+					}
+					task = std::move(queue.front());
+					queue.pop_front();
+				}
+				task();
+			}
+		}
+	};
+
+	//Shared pool with one worker less than there are hardware threads, since the calling thread always helps
+	//inline instead of static, so that all translation units share the same pool
+	inline ThreadPool& Pool()
+	{
+		static ThreadPool pool(ThreadCount() - 1);
+		return pool;
+	}
+
+	//Calls func(i) for every i in [begin, end), distributed over the calling thread and the shared pool
+	//Blocks until all calls returned. Can be nested, because the calling thread works on the range itself instead of only waiting for the pool
+	template<typename F>
+	static void For(int begin, int end, F func)
+	{
+		int count = end - begin;
+		int helpers = std::min(Pool().GetThreadCount(), count - 1);
+		if(helpers <= 0)
+		{
+			for(int i = begin; i < end; i++)
+			{
+				func(i);
+			}
+			return;
+		}
+
+		//Helpers that only start after all indices were taken must not touch func anymore, everything else they access is kept alive by the shared pointer
+		struct Job
+		{
+			std::atomic<int> next;
+			std::atomic<int> done = 0;
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+		std::shared_ptr<Job> job = std::make_shared<Job>();
+		job->next = begin;
+		auto run = [job, end, count, &func]()
+		{
+			for(int i = job->next++; i < end; i = job->next++)
+			{
+				func(i);
+				if(++job->done == count)
+				{
+					std::lock_guard<std::mutex> lock(job->mutex);
+					job->finished.notify_all();
+				}
+			}
+		};
+		for(int i = 0; i < helpers; i++)
+		{
+			Pool().Submit(run);
+		}
+		run();
+
+		std::unique_lock<std::mutex> lock(job->mutex);
+		job->finished.wait(lock, [&]() { return job->done == count; });
+	}
+
+	//Like For, but splits [begin, end) into one contiguous chunk per thread, chunk 0 runs on the calling thread and chunk c on pool worker c - 1
+	//Repeated calls over the same range give each thread the same part of the data, so memory that was first touched with the same split stays local on NUMA systems
+	//Chunks that were not started yet when the calling thread is done with its own (e.g. because the worker is busy in a nested call) are taken over by the calling thread
+	template<typename F>
+	static void ForStatic(int begin, int end, F func)
+	{
+		int count = end - begin;
+		int chunks = std::min(Pool().GetThreadCount() + 1, count);
+		if(chunks <= 1)
+		{
+			for(int i = begin; i < end; i++)
+			{
+				func(i);
+			}
+			return;
+		}
+
+		struct Job
+		{
+			std::vector<std::atomic<bool>> claimed;
+			std::atomic<int> done = 0;
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+		std::shared_ptr<Job> job = std::make_shared<Job>();
+		job->claimed = std::vector<std::atomic<bool>>(chunks);
+		auto run = [job, begin, count, chunks, &func](int chunk)
+		{
+			if(job->claimed[chunk].exchange(true))
+			{
+				return;
+			}
+			int from = begin + static_cast<int>(static_cast<int64_t>(count) * chunk / chunks);
+			int to = begin + static_cast<int>(static_cast<int64_t>(count) * (chunk + 1) / chunks);
+			for(int i = from; i < to; i++)
+			{
+				func(i);
+			}
+			if(++job->done == chunks)
+			{
+				std::lock_guard<std::mutex> lock(job->mutex);
+				job->finished.notify_all();
+			}
+		};
+		for(int c = 1; c < chunks; c++)
+		{
+			Pool().SubmitTo(c - 1, [run, c]() { run(c); });
+		}
+		for(int c = 0; c < chunks; c++)
+		{
+			run(c);
+		}
+
+		std::unique_lock<std::mutex> lock(job->mutex);
+		job->finished.wait(lock, [&]() { return job->done == chunks; });
+	}
+}
\ No newline at end of file
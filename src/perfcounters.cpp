@@ -0,0 +1,155 @@
+#include "perfcounters.h"
+#include <format>
+#include <algorithm>
+
+#include "parallel.h"
+
+#ifdef __linux__
+#include <filesystem>
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+//Type and config of each Counter for perf_event_attr
+static const uint64_t EVENTS[PerfCounters::Count][2] =
+{
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) }
+};
+#endif
+
+PerfCounters::~PerfCounters()
+{
+	Close();
+}
+
+bool PerfCounters::Open()
+{
+	Close();
+#ifdef __linux__
+	//The shared pool is started first, so that its workers are counted as well
+	Parallel::Pool();
+	int lastErrno = 0;
+	for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("/proc/self/task"))
+	{
+		pid_t tid = static_cast<pid_t>(std::stoi(entry.path().filename().string()));
+		std::array<int, Count> fds;
+		for(int c = 0; c < Count; c++)
+		{
+			perf_event_attr attr = {};
+			attr.size = sizeof(attr);
+			attr.type = static_cast<uint32_t>(EVENTS[c][0]);
+			attr.config = EVENTS[c][1];
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			fds[c] = static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+			if(fds[c] < 0)
+			{
+				lastErrno = errno;
+			}
+			available[c] = available[c] || fds[c] >= 0;
+		}
+		threads.push_back(fds);
+	}
+	if(std::none_of(available.begin(), available.end(), [](bool a) { return a; }))
+	{
+		bool denied = lastErrno == EACCES || lastErrno == EPERM;
+		error = std::format("Hardware counters are not available ({0}){1}", std::strerror(lastErrno), denied ? ", see /proc/sys/kernel/perf_event_paranoid" : "");
+		Close();
+		return false;
+	}
+	return true;
+#else
+	error = "Hardware counters are only supported on Linux";
+	return false;
+#endif
+}
+
+void PerfCounters::Start()
+{
+#ifdef __linux__
+	for(const std::array<int, Count>& fds : threads)
+	{
+		for(int fd : fds)
+		{
+			if(fd >= 0)
+			{
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+	}
+#endif
+}
+
+PerfCounters::Sample PerfCounters::Stop()
+{
+	Sample sample;
+	for(int c = 0; c < Count; c++)
+	{
+		sample[c] = available[c] ? 0 : -1;
+	}
+#ifdef __linux__
+	for(const std::array<int, Count>& fds : threads)
+	{
+		for(int c = 0; c < Count; c++)
+		{
+			if(fds[c] < 0)
+			{
+				continue;
+			}
+			ioctl(fds[c], PERF_EVENT_IOC_DISABLE, 0);
+			//Value, time enabled and time running
+			uint64_t values[3] = {};
+			if(read(fds[c], values, sizeof(values)) == sizeof(values) && values[2] > 0)
+			{
+				sample[c] += static_cast<int64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+			}
+		}
+	}
+#endif
+	return sample;
+}
+
+bool PerfCounters::IsAvailable(Counter counter) const
+{
+	return available[counter];
+}
+
+const std::string& PerfCounters::GetError() const
+{
+	return error;
+}
+
+const char* PerfCounters::GetName(Counter counter)
+{
+	static const char* names[Count] = { "cycles", "instructions", "L1d misses", "LLC misses", "branch misses", "dTLB misses" };
+	return names[counter];
+}
+
+void PerfCounters::Close()
+{
+#ifdef __linux__
+	for(const std::array<int, Count>& fds : threads)
+	{
+		for(int fd : fds)
+		{
+			if(fd >= 0)
+			{
+				close(fd);
+			}
+		}
+	}
+#endif
+	threads.clear();
+	available.fill(false);
+}
\ No newline at end of file
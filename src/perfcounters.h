@@ -0,0 +1,50 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+//Hardware performance counters (perf_event_open on Linux) of all threads of the process, including the workers of the shared thread pool
+//Counters that are not available (other platforms, perf_event_paranoid, virtual machines without a PMU) report -1, so callers can always print what is there
+//Only user space events are counted, which is allowed for the own process with the default settings of most distributions
+class PerfCounters
+{
+public:
+	enum Counter
+	{
+		Cycles = 0,
+		Instructions = 1,
+		L1dMisses = 2,
+		LlcMisses = 3,
+		BranchMisses = 4,
+		DtlbMisses = 5,
+		Count = 6
+	};
+
+	//Counts per event, scaled up if the kernel had to multiplex the counters, -1 if unavailable
+	using Sample = std::array<int64_t, Count>;
+
+	PerfCounters() = default;
+	~PerfCounters();
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	//Opens the counters for all threads that exist at this point, false if not a single counter could be opened
+	bool Open();
+	//Resets and starts all counters
+	void Start();
+	//Stops all counters and returns the sum over all threads since Start
+	Sample Stop();
+	bool IsAvailable(Counter counter) const;
+	const std::string& GetError() const;
+
+	static const char* GetName(Counter counter);
+
+private:
+	//File descriptors of each counter per thread, -1 if it could not be opened
+	std::vector<std::array<int, Count>> threads;
+	std::array<bool, Count> available = {};
+	std::string error;
+
+	void Close();
+};
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "planekernel.h"
+#include <cstring>
+#include <algorithm>
+
+#include "simulation.h"
+#include "parallel.h"
+#include "neighbourhood.h"
+
+PlaneKernel::PlaneKernel(const StaticSimSettings& settings)
+{
+	this->settings = settings;
+	dimSize = settings.size[0];
+	planeSize = static_cast<uint64_t>(dimSize) * dimSize;
+	maxNeighbours = Neighbourhood::Get(settings.neighbourMode).count;
+	aliveState = static_cast<uint8_t>(settings.states - 1);
+
+	rule = std::vector<uint8_t>(settings.states * (maxNeighbours + 1));
+	for(int state = 0; state < settings.states; state++)
+	{
+		for(int neighbours = 0; neighbours <= maxNeighbours; neighbours++)
+		{
+			rule[(state * (maxNeighbours + 1)) + neighbours] = static_cast<uint8_t>(Simulation::NextState(settings, state, neighbours));
+		}
+	}
+
+	for(int i = 0; i < 3; i++)
+	{
+		planes[i] = std::vector<uint8_t>(planeSize);
+		sums[i] = std::vector<uint8_t>(planeSize);
+	}
+	rowSums = std::vector<uint8_t>(planeSize);
+	rowStats = std::vector<Stats>(dimSize);
+	wrapIndex = std::vector<int>(dimSize + 2);
+	for(int i = -1; i <= dimSize; i++)
+	{
+		bool inside = i >= 0 && i < dimSize;
+		wrapIndex[i + 1] = inside ? i : (settings.wrap[0] ? (i + dimSize) % dimSize : -1);
+	}
+}
+
+void PlaneKernel::Begin(const uint8_t* prev, const uint8_t* curr)
+{
+	Load(prev, 0);
+	Load(curr, 1);
+	Neighbourhood::Visit(settings.neighbourMode, [&](auto hood)
+	{
+		if constexpr(decltype(hood)::MODE == NeighbourMode::Moore)
+		{
+			Sum(0);
+			Sum(1);
+		}
+	});
+}
+
+void PlaneKernel::Next(const uint8_t* next, uint8_t* out, Stats& stats)
+{
+	Load(next, 2);
+
+	int n = dimSize;
+	//Planes z - 1, z, z + 1, indexed by the z offset of a neighbour + 1
+	const uint8_t* planeData[3] = { planes[0].data(), planes[1].data(), planes[2].data() };
+	const uint8_t* currPlane = planeData[1];
+	Neighbourhood::Visit(settings.neighbourMode, [&](auto hood)
+	{
+		using Hood = decltype(hood);
+		if constexpr(Hood::MODE == NeighbourMode::Moore)
+		{
+			Sum(2);
+		}
+		Parallel::For(0, n, [&](int y)
+		{
+			Stats row;
+			for(int x = 0; x < n; x++)
+			{
+				uint64_t i = (static_cast<uint64_t>(y) * n) + x;
+				int count = 0;
+				if constexpr(Hood::MODE == NeighbourMode::Moore)
+				{
+					count = sums[0][i] + sums[1][i] + sums[2][i] - (currPlane[i] == aliveState ? 1 : 0);
+				}
+				else
+				{
+					Hood::ForEach([&](const Neighbourhood::Offset& o)
+					{
+						int nx = wrapIndex[x + o[0] + 1];
+						int ny = wrapIndex[y + o[1] + 1];
+						count += nx >= 0 && ny >= 0 && planeData[o[2] + 1][(static_cast<uint64_t>(ny) * n) + nx] == aliveState;
+					});
+				}
+				uint8_t state = rule[(currPlane[i] * (maxNeighbours + 1)) + count];
+				out[i] = state;
+				row.changed += state != currPlane[i];
+				row.population += state != 0;
+				row.alive += state == aliveState;
+			}
+			rowStats[y] = row;
+		});
+	});
+	for(const Stats& row : rowStats)
+	{
+		stats.changed += row.changed;
+		stats.population += row.population;
+		stats.alive += row.alive;
+	}
+
+	std::swap(planes[0], planes[1]);
+	std::swap(planes[1], planes[2]);
+	std::swap(sums[0], sums[1]);
+	std::swap(sums[1], sums[2]);
+}
+
+uint64_t PlaneKernel::GetPlaneSize() const
+{
+	return planeSize;
+}
+
+void PlaneKernel::Load(const uint8_t* plane, int slot)
+{
+	std::vector<uint8_t>& target = planes[slot];
+	if(plane == nullptr)
+	{
+		std::fill(target.begin(), target.end(), 0);
+	}
+	else
+	{
+		std::memcpy(target.data(), plane, planeSize);
+	}
+}
+
+void PlaneKernel::Sum(int slot)
+{
+	//3x3 sums of alive cells, first along x and then along y
+	int n = dimSize;
+	const std::vector<uint8_t>& target = planes[slot];
+	std::vector<uint8_t>& out = sums[slot];
+	Parallel::For(0, n, [&](int y)
+	{
+		const uint8_t* row = &target[static_cast<uint64_t>(y) * n];
+		uint8_t* sumRow = &rowSums[static_cast<uint64_t>(y) * n];
+		for(int x = 0; x < n; x++)
+		{
+			int sum = 0;
+			for(int k = 0; k < 3; k++)
+			{
+				int nx = wrapIndex[x + k];
+				sum += nx >= 0 && row[nx] == aliveState;
+			}
+			sumRow[x] = static_cast<uint8_t>(sum);
+		}
+	});
+	Parallel::For(0, n, [&](int y)
+	{
+		uint8_t* outRow = &out[static_cast<uint64_t>(y) * n];
+		for(int x = 0; x < n; x++)
+		{
+			int sum = 0;
+			for(int k = 0; k < 3; k++)
+			{
+				int ny = wrapIndex[y + k];
+				sum += ny >= 0 ? rowSums[(static_cast<uint64_t>(ny) * n) + x] : 0;
+			}
+			outRow[x] = static_cast<uint8_t>(sum);
+		}
+	});
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "config.h"
+
+//Next state computation for grids with one byte per cell (0 = empty, states - 1 = alive) that are processed plane by plane along z
+//Begin() takes the first two planes and every Next() call one more plane, then computes the plane in the middle
+//The planes are copied, so callers can pass views that are unmapped or overwritten afterwards
+class PlaneKernel
+{
+public:
+	struct Stats
+	{
+		uint64_t changed = 0;
+		uint64_t population = 0;
+		uint64_t alive = 0;
+	};
+
+	PlaneKernel() = default;
+	PlaneKernel(const StaticSimSettings& settings);
+
+	//nullptr stands for a plane outside of the grid without wrapping
+	void Begin(const uint8_t* prev, const uint8_t* curr);
+	//Writes the next states of the plane before next to out (dimSize^2 cells) and adds its statistics to stats
+	void Next(const uint8_t* next, uint8_t* out, Stats& stats);
+
+	uint64_t GetPlaneSize() const;
+
+private:
+	StaticSimSettings settings = {};
+	int dimSize = 0;
+	uint64_t planeSize = 0;
+	int maxNeighbours = 26;
+	uint8_t aliveState = 1;
+
+	//Next state for each (state, neighbours) pair
+	std::vector<uint8_t> rule;
+	//Copies of the planes z - 1, z, z + 1
+	std::vector<uint8_t> planes[3];
+	//Alive cells in the 3x3 square around each cell of planes (Moore only)
+	std::vector<uint8_t> sums[3];
+	std::vector<uint8_t> rowSums;
+	std::vector<Stats> rowStats;
+	//Index of x - 1 .. x + 1 for x in [-1, dimSize], -1 outside of the grid
+	std::vector<int> wrapIndex;
+
+	void Load(const uint8_t* plane, int slot);
+	//Fills sums[slot] from planes[slot], only called by the Moore kernel
+	void Sum(int slot);
+};
\ No newline at end of file
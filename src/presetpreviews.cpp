@@ -0,0 +1,242 @@
+#include "presetpreviews.h"
+#include <format>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+#include "simulation.h"
+#include "raycaster.h"
+#include "clusters.h"
+#include "gradient.h"
+#include "gradientpresets.h"
+
+namespace
+{
+	const char PREVIEW_MAGIC[4] = { 'C', 'A', '3', 'P' };
+	const uint32_t PREVIEW_SEED = 1;
+
+	//Fixed layout of the cache files, followed by size * size RGBA pixels
+	struct PreviewHeader
+	{
+		char magic[4];
+		int32_t size;
+		int32_t steps;
+		int32_t cells;
+		int32_t clusters;
+		int32_t largest;
+		float changed;
+	};
+}
+
+PresetPreviews::PresetPreviews(const std::filesystem::path& cacheDir, int steps, int workerCount) : cacheDir(cacheDir), steps(std::max(steps, 0))
+{
+	std::error_code error;
+	std::filesystem::create_directories(cacheDir, error);
+	for(int i = 0; i < std::max(workerCount, 1); i++)
+	{
+		workers.emplace_back(&PresetPreviews::Work, this);
+	}
+}
+
+PresetPreviews::~PresetPreviews()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	queueChanged.notify_all();
+	for(std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void PresetPreviews::Request(const Preset& preset)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(!previews.try_emplace(Hash(preset), nullptr).second)
+		{
+			return;
+		}
+		loads.push_back(preset);
+		pending++;
+	}
+	queueChanged.notify_one();
+}
+
+std::shared_ptr<const PresetPreviews::Preview> PresetPreviews::Get(const Preset& preset) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = previews.find(Hash(preset));
+	return it != previews.end() ? it->second : nullptr;
+}
+
+int PresetPreviews::GetPending() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pending;
+}
+
+void PresetPreviews::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	previewReady.wait(lock, [this]() { return pending == 0; });
+}
+
+uint64_t PresetPreviews::Hash(const Preset& preset) const
+{
+	std::string key = std::format("{0}|{1}|{2}|{3}|{4}|{5}|{6}|{7}|{8}|{9}|{10}|{11}", SIM_VERSION, static_cast<int>(preset.fillShape), preset.fillDiameter, preset.fillProb,
+		static_cast<int>(preset.neighbourMode), preset.states, preset.surviveRule, preset.spawnRule, PREVIEW_DIM_SIZE, PREVIEW_IMAGE_SIZE, PREVIEW_SEED, steps);
+	//FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for(char c : key)
+	{
+		hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+	}
+	return hash;
+}
+
+void PresetPreviews::Work()
+{
+	while(true)
+	{
+		Preset preset("", FillShape::Cube, 0, 0.0f, NeighbourMode::Moore, 2, "", "");
+		bool load;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queueChanged.wait(lock, [this]() { return stopping || !loads.empty() || !renders.empty(); });
+			if(stopping)
+			{
+				return;
+			}
+			load = !loads.empty();
+			std::deque<Preset>& queue = load ? loads : renders;
+			preset = queue.front();
+			queue.pop_front();
+		}
+
+		uint64_t hash = Hash(preset);
+		std::shared_ptr<Preview> preview = load ? Load(CacheFile(hash)) : Render(preset);
+		if(preview == nullptr)
+		{
+			//Not cached, simulated after all other cached previews were loaded
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				renders.push_back(preset);
+			}
+			queueChanged.notify_one();
+			continue;
+		}
+		if(!load)
+		{
+			Save(CacheFile(hash), *preview);
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			previews[hash] = preview;
+			pending--;
+		}
+		previewReady.notify_all();
+	}
+}
+
+std::shared_ptr<PresetPreviews::Preview> PresetPreviews::Render(const Preset& preset) const
+{
+	StaticSimSettings settings = preset.ToSettings({ PREVIEW_DIM_SIZE, PREVIEW_DIM_SIZE, PREVIEW_DIM_SIZE }, { true, true, true });
+	Simulation simulation(settings, PREVIEW_SEED);
+	//The steps in between are not needed, only the last one is simulated on its own for the changes
+	if(steps > 1)
+	{
+		simulation.Step(steps - 1);
+		//Symmetric steps are only expanded when the grid is read, the changes below should only be the ones of the last step
+		simulation.GetGrid();
+	}
+	if(steps > 0)
+	{
+		simulation.Step();
+	}
+	const Grid3d<IntCell>& grid = simulation.GetGrid();
+
+	std::shared_ptr<Preview> preview = std::make_shared<Preview>();
+	preview->size = PREVIEW_IMAGE_SIZE;
+	preview->steps = steps;
+	Clusters clusters;
+	clusters.Update(grid);
+	Clusters::Stats stats = clusters.GetStats();
+	preview->cells = stats.cells;
+	preview->clusters = stats.clusters;
+	preview->largest = stats.largest;
+	preview->changed = steps > 0 ? grid.GetChanges().size() / static_cast<float>(PREVIEW_DIM_SIZE * PREVIEW_DIM_SIZE * PREVIEW_DIM_SIZE) : 0.0f;
+
+	raylib::Camera cam = {};
+	float camDistance = PREVIEW_DIM_SIZE * 1.6f;
+	cam.position = raylib::Vector3 { camDistance * 0.7f, camDistance * 0.6f, camDistance * 0.7f };
+	cam.target = raylib::Vector3 { 0.0f, 0.0f, 0.0f };
+	cam.up = raylib::Vector3 { 0.0f, 1.0f, 0.0f };
+	cam.fovy = RENDERER_FOV;
+	Raycaster<IntCell> raycaster;
+	raycaster.Update(grid, ColorMode::State, Gradient::Generate(Gradient::GetPreset(GradientPreset::Hue), GRADIENT_STEPS));
+	raycaster.Render(cam, preview->size, preview->size, preview->pixels);
+	return preview;
+}
+
+std::shared_ptr<PresetPreviews::Preview> PresetPreviews::Load(const std::filesystem::path& file) const
+{
+	FILE* stream = std::fopen(file.string().c_str(), "rb");
+	if(stream == nullptr)
+	{
+		return nullptr;
+	}
+	std::shared_ptr<Preview> preview = std::make_shared<Preview>();
+	PreviewHeader header;
+	bool valid = std::fread(&header, sizeof(header), 1, stream) == 1 && std::memcmp(header.magic, PREVIEW_MAGIC, sizeof(PREVIEW_MAGIC)) == 0 && header.size == PREVIEW_IMAGE_SIZE;
+	if(valid)
+	{
+		preview->pixels.resize(header.size * header.size);
+		valid = std::fread(preview->pixels.data(), sizeof(raylib::Color), preview->pixels.size(), stream) == preview->pixels.size();
+	}
+	std::fclose(stream);
+	if(!valid)
+	{
+		return nullptr;
+	}
+	preview->size = header.size;
+	preview->steps = header.steps;
+	preview->cells = header.cells;
+	preview->clusters = header.clusters;
+	preview->largest = header.largest;
+	preview->changed = header.changed;
+	preview->fromCache = true;
+	return preview;
+}
+
+void PresetPreviews::Save(const std::filesystem::path& file, const Preview& preview) const
+{
+	//Written to a temporary file first, so that other processes never read a partial file
+	std::filesystem::path temp = file;
+	temp += std::format(".{0}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+	FILE* stream = std::fopen(temp.string().c_str(), "wb");
+	if(stream == nullptr)
+	{
+		return;
+	}
+	PreviewHeader header = { { PREVIEW_MAGIC[0], PREVIEW_MAGIC[1], PREVIEW_MAGIC[2], PREVIEW_MAGIC[3] }, preview.size, preview.steps, preview.cells, preview.clusters, preview.largest, preview.changed };
+	bool written = std::fwrite(&header, sizeof(header), 1, stream) == 1 && std::fwrite(preview.pixels.data(), sizeof(raylib::Color), preview.pixels.size(), stream) == preview.pixels.size();
+	written = std::fclose(stream) == 0 && written;
+	std::error_code error;
+	if(written)
+	{
+		std::filesystem::rename(temp, file, error);
+	}
+	if(!written || error)
+	{
+		std::filesystem::remove(temp, error);
+	}
+}
+
+std::filesystem::path PresetPreviews::CacheFile(uint64_t hash) const
+{
+	return cacheDir / std::format("{0:016x}.preview", hash);
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <cstdint>
+
+#include "config.h"
+#include "presets.h"
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+//Simulates presets headless on background worker threads and renders a small thumbnail and statistics of the result
+//Previews are cached on disk in files named after a hash of the preset, the preview settings and SIM_VERSION, so they are only computed again if any of these change
+//Cached previews are loaded before any preset is simulated, so with a warm cache all previews are ready almost immediately
+class PresetPreviews
+{
+public:
+	struct Preview
+	{
+		//size * size pixels, top row first
+		std::vector<raylib::Color> pixels;
+		int size = 0;
+		int steps = 0;
+		//Non empty cells, clusters and the largest cluster after the last step
+		int cells = 0;
+		int clusters = 0;
+		int largest = 0;
+		//Share of the cells that changed in the last step
+		float changed = 0.0f;
+		bool fromCache = false;
+	};
+
+	PresetPreviews(const std::filesystem::path& cacheDir, int steps = PREVIEW_STEPS, int workerCount = PREVIEW_WORKERS);
+	//Stops the workers after the previews they are working on, queued presets are dropped
+	~PresetPreviews();
+
+	PresetPreviews(const PresetPreviews&) = delete;
+	PresetPreviews& operator=(const PresetPreviews&) = delete;
+
+	//Queues the preset, if its preview was not requested before
+	void Request(const Preset& preset);
+	//nullptr while the preview is not ready, thread safe
+	std::shared_ptr<const Preview> Get(const Preset& preset) const;
+	//Amount of requested previews that are not ready yet
+	int GetPending() const;
+	//Blocks until all requested previews are ready
+	void Wait();
+
+	//Key of the preview, which does not depend on the name of the preset
+	uint64_t Hash(const Preset& preset) const;
+
+private:
+	std::filesystem::path cacheDir;
+	int steps;
+
+	std::vector<std::thread> workers;
+	//Presets whose cache file was not read yet and presets that have to be simulated
+	std::deque<Preset> loads;
+	std::deque<Preset> renders;
+	std::map<uint64_t, std::shared_ptr<const Preview>> previews;
+	int pending = 0;
+	mutable std::mutex mutex;
+	std::condition_variable queueChanged;
+	std::condition_variable previewReady;
+	bool stopping = false;
+
+	void Work();
+	std::shared_ptr<Preview> Render(const Preset& preset) const;
+	std::shared_ptr<Preview> Load(const std::filesystem::path& file) const;
+	void Save(const std::filesystem::path& file, const Preview& preview) const;
+	std::filesystem::path CacheFile(uint64_t hash) const;
+};
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
+#include <algorithm>
 #include "config.h"
+#include "rule.h"
 
 struct Preset
 {
@@ -20,6 +22,23 @@ struct Preset
 	{
 		
 	}
+
+	//The fill has to fit into the smallest extent of the grid
+	StaticSimSettings ToSettings(const Extent& size, const AxisWrap& wrap) const
+	{
+		return StaticSimSettings
+		{
+			.size = size,
+			.fillShape = fillShape,
+			.fillDiameter = static_cast<float>(std::clamp(fillDiameter, 0, std::min({ size[0], size[1], size[2] }))),
+			.fillProb = fillProb,
+			.wrap = wrap,
+			.neighbourMode = neighbourMode,
+			.states = states,
+			.surviveRule = Rule::Parse(surviveRule, neighbourMode),
+			.spawnRule = Rule::Parse(spawnRule, neighbourMode)
+		};
+	}
 };
 
 const Preset PRESETS[] =
@@ -48,3 +67,16 @@ const Preset PRESETS[] =
 };
 
 const Preset START_PRESET = PRESETS[3];
+
+//Returns the preset with the given name or nullptr
+static const Preset* FindPreset(const std::string& name)
+{
+	for(const Preset& preset : PRESETS)
+	{
+		if(preset.name == name)
+		{
+			return &preset;
+		}
+	}
+	return nullptr;
+}
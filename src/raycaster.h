@@ -0,0 +1,259 @@
+#pragma once
+#include <type_traits>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+#include "config.h"
+#include "grid3d.h"
+#include "parallel.h"
+#include "cellcolor.h"
+#include "clusters.h"
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+//Renders a grid on the CPU by casting one ray per pixel, does not require a window or graphics device
+//Empty space is skipped with an occupancy pyramid, where a node on level k is set if any of the 2^k^3 cells below it is non empty
+template<typename T>
+class Raycaster
+{
+	static_assert(std::is_base_of<Cell, T>::value, "T must derive from Cell");
+
+public:
+	//Recolors the cells and rebuilds the pyramid, if the grid or the color settings changed since the last call
+	void Update(const Grid3d<T>& grid, ColorMode colorMode, const std::vector<raylib::Color>& gradient)
+	{
+		bool gradientChanged = gradient.size() != cacheGradient.size() || !std::equal(gradient.begin(), gradient.end(), cacheGradient.begin(), [](const raylib::Color& a, const raylib::Color& b)
+		{
+			return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+		});
+		if(grid.GetRevision() == cacheRevision && colorMode == cacheColorMode && !gradientChanged)
+		{
+			return;
+		}
+		cacheRevision = grid.GetRevision();
+		cacheColorMode = colorMode;
+		cacheGradient = gradient;
+
+		if(grid.GetSize() != gridSize)
+		{
+			gridSize = grid.GetSize();
+			colors = std::vector<raylib::Color>(grid.GetCellCount());
+			levels.clear();
+			levelSizes.clear();
+			for(Extent size = gridSize; ; )
+			{
+				levels.push_back(std::vector<uint8_t>(size[0] * size[1] * size[2], 0));
+				levelSizes.push_back(size);
+				if(size[0] == 1 && size[1] == 1 && size[2] == 1)
+				{
+					break;
+				}
+				for(int& s : size)
+				{
+					s = (s + 1) / 2;
+				}
+			}
+		}
+
+		CellColor::ColorFunc colorFunc = CellColor::Get(colorMode);
+		if(colorMode == ColorMode::Cluster)
+		{
+			clusters.Update(grid);
+		}
+		Parallel::For(0, gridSize[2], [&](int z)
+		{
+			int i = z * gridSize[0] * gridSize[1];
+			for(int y = 0; y < gridSize[1]; y++)
+			{
+				for(int x = 0; x < gridSize[0]; x++, i++)
+				{
+					const T& cell = grid[i];
+					if(cell.IsEmpty())
+					{
+						colors[i] = raylib::Color { 0, 0, 0, 0 };
+					}
+					else
+					{
+						colors[i] = colorMode == ColorMode::Cluster ? CellColor::Cluster(clusters.GetLabels()[i], gradient) : colorFunc(gridSize, x, y, z, cell.RenderGradient(), gradient);
+					}
+					levels[0][i] = cell.IsEmpty() ? 0 : 1;
+				}
+			}
+		});
+
+		for(int level = 1; level < static_cast<int>(levels.size()); level++)
+		{
+			const Extent& size = levelSizes[level];
+			const Extent& prevSize = levelSizes[level - 1];
+			const std::vector<uint8_t>& prev = levels[level - 1];
+			std::vector<uint8_t>& curr = levels[level];
+			Parallel::For(0, size[2], [&](int z)
+			{
+				for(int y = 0; y < size[1]; y++)
+				{
+					for(int x = 0; x < size[0]; x++)
+					{
+						uint8_t any = 0;
+						for(int c = 0; c < 8 && !any; c++)
+						{
+							int px = x * 2 + (c & 1);
+							int py = y * 2 + ((c >> 1) & 1);
+							int pz = z * 2 + (c >> 2);
+							if(px < prevSize[0] && py < prevSize[1] && pz < prevSize[2])
+							{
+								any |= prev[(pz * prevSize[0] * prevSize[1]) + (py * prevSize[0]) + px];
+							}
+						}
+						curr[(z * size[0] * size[1]) + (y * size[0]) + x] = any;
+					}
+				}
+			});
+		}
+	}
+
+	//Renders the last updated grid into pixels (width * height, row major, top row first) in parallel tiles
+	//The camera uses world coordinates, in which the grid is centered around the origin like in Renderer
+	void Render(const raylib::Camera& cam, int width, int height, std::vector<raylib::Color>& pixels) const
+	{
+		static const int tileSize = 32;
+		pixels.resize(width * height);
+
+		raylib::Vector3 forward = raylib::Vector3Normalize(raylib::Vector3Subtract(cam.target, cam.position));
+		raylib::Vector3 right = raylib::Vector3Normalize(raylib::Vector3CrossProduct(forward, cam.up));
+		raylib::Vector3 up = raylib::Vector3CrossProduct(right, forward);
+		float tanHalfFov = std::tan(cam.fovy * DEG2RAD * 0.5f);
+		float aspect = width / static_cast<float>(height);
+		raylib::Vector3 origin = raylib::Vector3Add(cam.position, raylib::Vector3 { gridSize[0] * 0.5f, gridSize[1] * 0.5f, gridSize[2] * 0.5f });
+
+		int tilesX = (width + tileSize - 1) / tileSize;
+		int tilesY = (height + tileSize - 1) / tileSize;
+		Parallel::For(0, tilesX * tilesY, [&](int tile)
+		{
+			int x0 = (tile % tilesX) * tileSize;
+			int y0 = (tile / tilesX) * tileSize;
+			for(int py = y0; py < std::min(y0 + tileSize, height); py++)
+			{
+				for(int px = x0; px < std::min(x0 + tileSize, width); px++)
+				{
+					float sx = (2.0f * (px + 0.5f) / width - 1.0f) * aspect * tanHalfFov;
+					float sy = (1.0f - 2.0f * (py + 0.5f) / height) * tanHalfFov;
+					raylib::Vector3 dir = raylib::Vector3Normalize(raylib::Vector3Add(forward, raylib::Vector3Add(raylib::Vector3Scale(right, sx), raylib::Vector3Scale(up, sy))));
+					pixels[py * width + px] = Trace(origin, dir);
+				}
+			}
+		});
+	}
+
+private:
+	const raylib::Color BACKGROUND_COLOR = { 30, 30, 30, 255 };
+	//Simple directional light, brightness of faces whose normal points along x, y or z
+	const float FACE_SHADE[3] = { 0.8f, 1.0f, 0.65f };
+
+	Extent gridSize = {};
+	std::vector<raylib::Color> colors;
+	Clusters clusters;
+	std::vector<std::vector<uint8_t>> levels;
+	std::vector<Extent> levelSizes;
+	uint64_t cacheRevision = 0;
+	ColorMode cacheColorMode = ColorMode::State;
+	std::vector<raylib::Color> cacheGradient;
+
+	bool Occupied(int level, int x, int y, int z) const
+	{
+		const Extent& size = levelSizes[level];
+		return levels[level][(z * size[0] * size[1]) + (y * size[0]) + x] != 0;
+	}
+
+	//Steps through the grid (in grid coordinates) with a 3d DDA, skipping the largest empty pyramid node around the current cell in each step
+	raylib::Color Trace(const raylib::Vector3& origin, const raylib::Vector3& dir) const
+	{
+		static const float inf = std::numeric_limits<float>::infinity();
+		float o[3] = { origin.x, origin.y, origin.z };
+		float d[3] = { dir.x, dir.y, dir.z };
+		float inv[3];
+		for(int a = 0; a < 3; a++)
+		{
+			inv[a] = d[a] != 0.0f ? 1.0f / d[a] : inf;
+		}
+
+		//Intersection with the bounds of the grid
+		float tEnter = 0.0f;
+		float tExit = inf;
+		int axis = 0;
+		for(int a = 0; a < 3; a++)
+		{
+			if(d[a] == 0.0f)
+			{
+				if(o[a] < 0.0f || o[a] > gridSize[a])
+				{
+					return BACKGROUND_COLOR;
+				}
+				continue;
+			}
+			float t0 = (0.0f - o[a]) * inv[a];
+			float t1 = (gridSize[a] - o[a]) * inv[a];
+			if(t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+			if(t0 > tEnter)
+			{
+				tEnter = t0;
+				axis = a;
+			}
+			tExit = std::min(tExit, t1);
+		}
+		if(tEnter >= tExit)
+		{
+			return BACKGROUND_COLOR;
+		}
+
+		static const float eps = 1e-4f;
+		int topLevel = static_cast<int>(levels.size()) - 1;
+		float t = tEnter;
+		while(t < tExit)
+		{
+			int c[3];
+			for(int a = 0; a < 3; a++)
+			{
+				c[a] = std::clamp(static_cast<int>(std::floor(o[a] + d[a] * (t + eps))), 0, gridSize[a] - 1);
+			}
+			if(Occupied(0, c[0], c[1], c[2]))
+			{
+				raylib::Color color = colors[(c[2] * gridSize[0] * gridSize[1]) + (c[1] * gridSize[0]) + c[0]];
+				float shade = FACE_SHADE[axis];
+				return raylib::Color { static_cast<unsigned char>(color.r * shade), static_cast<unsigned char>(color.g * shade), static_cast<unsigned char>(color.b * shade), 255 };
+			}
+
+			int level = 0;
+			while(level < topLevel && !Occupied(level + 1, c[0] >> (level + 1), c[1] >> (level + 1), c[2] >> (level + 1)))
+			{
+				level++;
+			}
+
+			//Exit of the empty node
+			int size = 1 << level;
+			float tNext = inf;
+			for(int a = 0; a < 3; a++)
+			{
+				if(d[a] == 0.0f)
+				{
+					continue;
+				}
+				int nodeMin = (c[a] >> level) << level;
+				float bound = static_cast<float>(d[a] > 0.0f ? nodeMin + size : nodeMin);
+				float ta = (bound - o[a]) * inv[a];
+				if(ta < tNext)
+				{
+					tNext = ta;
+					axis = a;
+				}
+			}
+			t = std::max(tNext, t + eps);
+		}
+		return BACKGROUND_COLOR;
+	}
+};
\ No newline at end of file
@@ -7,6 +7,7 @@
 //Required in global namespace for the raylib & raygui includes
 #include <cstdlib>
 #include <cstring>
+#include <cmath>
 
 //For layout extension
 #include <utility>
@@ -17,6 +18,8 @@ extern "C"
 	namespace raylib
 	{
 		#include "raylib.h"
+		#include "raymath.h"
+		#include "rlgl.h"
 		namespace gui
 		{			
 			#include "raygui.h"
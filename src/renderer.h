@@ -2,9 +2,19 @@
 #include <type_traits>
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <memory>
 
 #include "config.h"
 #include "grid3d.h"
+#include "parallel.h"
+#include "cellbatch.h"
+#include "batchmesh.h"
+#include "mesher.h"
+#include "occupancy.h"
+#include "frustum.h"
+#include "cellcolor.h"
+#include "clusters.h"
 #define RAYGUI_STATIC
 #include "raylibinclude.h"
 
@@ -30,108 +40,561 @@ public:
 		raylib::UpdateCamera(&cam);
 	}
 
+	const raylib::Camera& GetCamera() const
+	{
+		return cam;
+	}
+
+	//Used to show multiple grids from the same view, only one renderer has to call Update()
+	void SetCamera(const raylib::Camera& cam)
+	{
+		this->cam = cam;
+	}
+
+	//Size of the area that is rendered to, if it is not the whole screen (e.g. a render texture)
+	void SetViewport(int width, int height)
+	{
+		viewportWidth = width;
+		viewportHeight = height;
+	}
+
+	//Ray through point (in pixels) of the viewport in world coordinates
+	raylib::Ray GetRay(raylib::Vector2 point) const
+	{
+		float width = static_cast<float>(GetViewportWidth());
+		float height = static_cast<float>(GetViewportHeight());
+		raylib::Matrix view = raylib::MatrixLookAt(cam.position, cam.target, cam.up);
+		raylib::Matrix proj = raylib::MatrixPerspective(cam.fovy * DEG2RAD, width / height, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+		float x = (2.0f * point.x) / width - 1.0f;
+		float y = 1.0f - (2.0f * point.y) / height;
+		raylib::Vector3 nearPoint = raylib::Vector3Unproject(raylib::Vector3 { x, y, 0.0f }, proj, view);
+		raylib::Vector3 farPoint = raylib::Vector3Unproject(raylib::Vector3 { x, y, 1.0f }, proj, view);
+		return raylib::Ray { cam.position, raylib::Vector3Normalize(raylib::Vector3Subtract(farPoint, nearPoint)) };
+	}
+
 	void Render(const Grid3d<T>& grid, const DynamicSimSettings& settings, const std::vector<raylib::Color>& gradient)
 	{
-		void (Renderer::*drawFunc)(float x, float y, float z, const raylib::Color& color);
+		UpdateColors(grid, settings, gradient);
+		if(settings.renderMode == RenderMode::Cube)
+		{
+			UpdateChunks();
+		}
+		else
+		{
+			//Billboards of enclosed cells are hidden behind their neighbours, points are too small to cover each other
+			UpdateCells(settings.renderMode == RenderMode::Quad);
+			UpdateBatch(settings.renderMode);
+		}
+
+		raylib::BeginMode3D(cam);
+
+		const Extent& size = grid.GetSize();
+		raylib::Vector3 halfSize = { size[0] * 0.5f, size[1] * 0.5f, size[2] * 0.5f };
+
+		raylib::DrawBoundingBox(raylib::BoundingBox { raylib::Vector3Negate(halfSize), halfSize }, BOUNDS_COLOR);
+
 		switch(settings.renderMode)
 		{
 			case RenderMode::Cube:
-				drawFunc = &Renderer::RenderCube;
-				break;
-			case RenderMode::Quad:
-				drawFunc = &Renderer::RenderQuad;
+				for(const RenderChunk& chunk : chunks)
+				{
+					if(chunk.visible)
+					{
+						chunk.meshes[chunk.level]->Draw();
+					}
+				}
 				break;
 			case RenderMode::Point:
-				drawFunc = &Renderer::RenderPoint;
+				BatchMesh::DrawLines(batch);
 				break;
 			default:
-				throw std::exception("Missing switch label in Renderer<T>::Render!");
+				batchMesh.Draw();
 				break;
 		}
 
-		raylib::Color (Renderer::*colorFunc)(int dimSize, int x, int y, int z, float t, const std::vector<raylib::Color>&gradient);
-		switch(settings.colorMode)
+		raylib::EndMode3D();
+	}
+
+	//Updates the color volume (one color per cell, alpha 0 for empty cells), if the grid or the color settings changed since the last call
+	//Only the changed cells are recolored, if the grid advanced by a single modification since the last call (except for cluster colors, where any change can merge or split clusters)
+	void UpdateColors(const Grid3d<T>& grid, const DynamicSimSettings& settings, const std::vector<raylib::Color>& gradient)
+	{
+		bool gradientChanged = gradient.size() != cacheGradient.size() || !std::equal(gradient.begin(), gradient.end(), cacheGradient.begin(), [](const raylib::Color& a, const raylib::Color& b)
 		{
-			case ColorMode::State:
-				colorFunc = &Renderer::ColorState;
-				break;
-			case ColorMode::Xyz:
-				colorFunc = &Renderer::ColorXYZ;
+			return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+		});
+		bool settingsChanged = settings.colorMode != cacheColorMode || gradientChanged || grid.GetSize() != gridSize;
+		if(grid.GetRevision() == cacheRevision && !settingsChanged)
+		{
+			return;
+		}
+		bool incremental = !settingsChanged && grid.GetChangesBase() == cacheRevision && settings.colorMode != ColorMode::Cluster;
+		cacheRevision = grid.GetRevision();
+		cacheColorMode = settings.colorMode;
+		cacheGradient = gradient;
+		colorsVersion++;
+
+		colorFunc = CellColor::Get(settings.colorMode);
+		if(settings.colorMode == ColorMode::Cluster)
+		{
+			clusters.Update(grid);
+		}
+
+		if(incremental)
+		{
+			for(int i : grid.GetChanges())
+			{
+				auto [x, y, z] = grid.GetCellPos(i);
+				colors[i] = CellColor(grid, i, x, y, z);
+				occupancy.Set(x, y, z, colors[i].a != 0);
+				MarkChunksDirty(x, y, z);
+			}
+			return;
+		}
+
+		if(grid.GetSize() != gridSize)
+		{
+			gridSize = grid.GetSize();
+			colors = std::vector<raylib::Color>(grid.GetCellCount());
+			for(int level = 1; level < RENDERER_LOD_LEVELS; level++)
+			{
+				Extent levelSize = LevelSize(level);
+				lodColors[level - 1] = std::vector<raylib::Color>(levelSize[0] * levelSize[1] * levelSize[2]);
+			}
+			occupancy = OccupancyMask(gridSize);
+			CreateChunks();
+		}
+		Parallel::For(0, gridSize[2], [&](int z)
+		{
+			int i = z * gridSize[0] * gridSize[1];
+			for(int y = 0; y < gridSize[1]; y++)
+			{
+				for(int x = 0; x < gridSize[0]; x++, i++)
+				{
+					colors[i] = CellColor(grid, i, x, y, z);
+					occupancy.Set(x, y, z, colors[i].a != 0);
+				}
+			}
+		});
+		for(RenderChunk& chunk : chunks)
+		{
+			chunk.pyramidDirty = true;
+			std::fill(std::begin(chunk.dirty), std::end(chunk.dirty), true);
+		}
+	}
+
+	//Rebuilds the packed list of visible cells from the color volume, if it changed since the last call
+	//With cullInterior, cells that are enclosed by 6 non empty neighbours are skipped
+	void UpdateCells(bool cullInterior)
+	{
+		if(cellsVersion == colorsVersion && cellsCullInterior == cullInterior)
+		{
+			return;
+		}
+		cellsVersion = colorsVersion;
+		cellsCullInterior = cullInterior;
+
+		//Each z slab is collected by one worker and the slabs are joined in order afterwards
+		raylib::Vector3 offset = raylib::Vector3AddValue(Offset(), 0.5f);
+		slabCells.resize(gridSize[2]);
+		Parallel::For(0, gridSize[2], [&](int z)
+		{
+			std::vector<RenderCell>& slab = slabCells[z];
+			slab.clear();
+			std::vector<uint64_t> visible(occupancy.GetWordsPerRow());
+			for(int y = 0; y < gridSize[1]; y++)
+			{
+				if(occupancy.RowCount(y, z) == 0)
+				{
+					continue;
+				}
+				const uint64_t* row = occupancy.Row(y, z);
+				if(cullInterior)
+				{
+					occupancy.VisibleRow(y, z, visible.data());
+					row = visible.data();
+				}
+				int rowStart = (z * gridSize[0] * gridSize[1]) + (y * gridSize[0]);
+				OccupancyMask::ForEachBit(row, occupancy.GetWordsPerRow(), [&](int x)
+				{
+					slab.push_back(RenderCell { raylib::Vector3 { x + offset.x, y + offset.y, z + offset.z }, colors[rowStart + x] });
+				});
+			}
+		});
+
+		cells.clear();
+		for(const std::vector<RenderCell>& slab : slabCells)
+		{
+			cells.insert(cells.end(), slab.begin(), slab.end());
+		}
+		cellsChanged = true;
+	}
+
+	//Selects the level of detail of each chunk and remeshes the visible chunks that are dirty on their level in parallel
+	void UpdateChunks()
+	{
+		UpdateLodBias();
+		SelectChunkLevels();
+
+		std::vector<RenderChunk*> pyramidChunks;
+		std::vector<RenderChunk*> meshChunks;
+		for(RenderChunk& chunk : chunks)
+		{
+			if(chunk.pyramidDirty)
+			{
+				pyramidChunks.push_back(&chunk);
+			}
+			if(chunk.visible && chunk.dirty[chunk.level])
+			{
+				meshChunks.push_back(&chunk);
+			}
+		}
+
+		//Blocks of all levels never cross chunk borders, so each chunk can downsample its own region
+		Parallel::For(0, static_cast<int>(pyramidChunks.size()), [&](int i)
+		{
+			UpdatePyramid(*pyramidChunks[i]);
+		});
+
+		raylib::Vector3 offset = Offset();
+		Parallel::For(0, static_cast<int>(meshChunks.size()), [&](int i)
+		{
+			RenderChunk& chunk = *meshChunks[i];
+			int blockSize = 1 << chunk.level;
+			int from[3];
+			int to[3];
+			for(int d = 0; d < 3; d++)
+			{
+				from[d] = chunk.from[d] / blockSize;
+				to[d] = (chunk.to[d] + blockSize - 1) / blockSize;
+			}
+			chunk.batch.Clear();
+			Mesher::BuildGreedy(LevelColors(chunk.level), LevelSize(chunk.level), from, to, static_cast<float>(blockSize), offset, chunk.batch);
+		});
+		for(RenderChunk* chunk : meshChunks)
+		{
+			chunk->meshes[chunk->level]->Upload(chunk->batch);
+			chunk->dirty[chunk->level] = false;
+		}
+	}
+
+	//Rebuilds the vertex batch from the cached cells, if the cells or the render mode changed since the last call
+	//Billboards depend on the camera orientation, so they are rebuilt whenever the camera moved
+	void UpdateBatch(RenderMode renderMode)
+	{
+		bool cameraMoved = !raylib::Vector3Equals(cam.position, batchCamPos) || !raylib::Vector3Equals(cam.target, batchCamTarget);
+		if(!cellsChanged && renderMode == batchRenderMode && (renderMode != RenderMode::Quad || !cameraMoved))
+		{
+			return;
+		}
+		cellsChanged = false;
+		batchRenderMode = renderMode;
+		batchCamPos = cam.position;
+		batchCamTarget = cam.target;
+
+		void (Renderer::*writeFunc)(int vertex, const RenderCell& cell);
+		int verticesPerCell = 0;
+		switch(renderMode)
+		{
+			case RenderMode::Quad:
+			{
+				raylib::Matrix view = raylib::MatrixLookAt(cam.position, cam.target, cam.up);
+				camRight = raylib::Vector3 { view.m0, view.m4, view.m8 };
+				camUp = raylib::Vector3 { view.m1, view.m5, view.m9 };
+				writeFunc = &Renderer::WriteQuad;
+				verticesPerCell = CellBatch::BILLBOARD_VERTICES;
 				break;
-			case ColorMode::Radius:
-				colorFunc = &Renderer::ColorRadius;
+			}
+			case RenderMode::Point:
+				writeFunc = &Renderer::WritePoint;
+				verticesPerCell = CellBatch::CROSS_VERTICES;
 				break;
 			default:
-				throw std::exception("Missing switch label in Renderer<T>::Render!");
+				throw std::exception("Missing switch label in Renderer<T>::UpdateBatch!");
 				break;
 		}
 
-		raylib::BeginMode3D(cam);
+		static const int cellsPerBlock = 4096;
+		int cellCount = static_cast<int>(cells.size());
+		batch.Resize(cellCount * verticesPerCell);
+		Parallel::For(0, (cellCount + cellsPerBlock - 1) / cellsPerBlock, [&](int block)
+		{
+			int to = std::min((block + 1) * cellsPerBlock, cellCount);
+			for(int i = block * cellsPerBlock; i < to; i++)
+			{
+				(this->*writeFunc)(i * verticesPerCell, cells[i]);
+			}
+		});
 
-		int dimSize = grid.GetDimSize();
-		float offset = -dimSize * 0.5f;
+		if(renderMode != RenderMode::Point)
+		{
+			batchMesh.Upload(batch);
+		}
+	}
+
+private:
+	int GetViewportWidth() const
+	{
+		return viewportWidth > 0 ? viewportWidth : raylib::GetScreenWidth();
+	}
 
-		raylib::DrawBoundingBox(raylib::BoundingBox { raylib::Vector3 { 0.0f + offset, 0.0f + offset, 0.0f + offset }, raylib::Vector3 { dimSize + offset, dimSize + offset, dimSize + offset } }, BOUNDS_COLOR);
+	int GetViewportHeight() const
+	{
+		return viewportHeight > 0 ? viewportHeight : raylib::GetScreenHeight();
+	}
 
-		int len = grid.GetDimSize() * grid.GetDimSize() * grid.GetDimSize();
-		for(int i = 0; i < len; i++)
+	struct RenderCell
+	{
+		raylib::Vector3 pos;
+		raylib::Color color;
+	};
+
+	struct RenderChunk
+	{
+		int from[3];
+		int to[3];
+		CellBatch batch;
+		std::unique_ptr<BatchMesh> meshes[RENDERER_LOD_LEVELS];
+		bool dirty[RENDERER_LOD_LEVELS];
+		bool pyramidDirty;
+		bool visible;
+		int level;
+	};
+
+	const raylib::Color BOUNDS_COLOR = { 245, 203, 66, 32 };
+
+	raylib::Camera cam;
+	int viewportWidth = 0;
+	int viewportHeight = 0;
+
+	Extent gridSize = {};
+	std::vector<raylib::Color> colors;
+	std::vector<raylib::Color> lodColors[RENDERER_LOD_LEVELS - 1];
+	OccupancyMask occupancy;
+	CellColor::ColorFunc colorFunc = nullptr;
+	Clusters clusters;
+	uint64_t cacheRevision = 0;
+	ColorMode cacheColorMode = ColorMode::State;
+	std::vector<raylib::Color> cacheGradient;
+	int colorsVersion = 0;
+
+	std::vector<RenderCell> cells;
+	std::vector<std::vector<RenderCell>> slabCells;
+	int cellsVersion = -1;
+	bool cellsCullInterior = false;
+	bool cellsChanged = false;
+
+	std::vector<RenderChunk> chunks;
+	int chunksPerAxis[3] = { 0, 0, 0 };
+	float lodBias = 1.0f;
+
+	CellBatch batch;
+	BatchMesh batchMesh;
+	RenderMode batchRenderMode = RenderMode::Quad;
+	raylib::Vector3 batchCamPos = {};
+	raylib::Vector3 batchCamTarget = {};
+	raylib::Vector3 camRight = {};
+	raylib::Vector3 camUp = {};
+
+	raylib::Color CellColor(const Grid3d<T>& grid, int index, int x, int y, int z)
+	{
+		const T& cell = grid[index];
+		if(cell.IsEmpty())
 		{
-			const T& cell = grid[i];
-			if(!cell.IsEmpty())
-			{
-				auto [x, y, z] = grid.GetCellPos(i);
-				raylib::Color c = (this->*colorFunc)(dimSize, x, y, z, cell.RenderGradient(), gradient);
-				(this->*drawFunc)(x + offset + 0.5f, y + offset + 0.5f, z + offset + 0.5f, c);
-			}
+			return raylib::Color { 0, 0, 0, 0 };
 		}
+		if(cacheColorMode == ColorMode::Cluster)
+		{
+			return CellColor::Cluster(clusters.GetLabels()[index], cacheGradient);
+		}
+		return colorFunc(gridSize, x, y, z, cell.RenderGradient(), cacheGradient);
+	}
 
-		raylib::EndMode3D();
+	//World position of the corner of the grid, which is centered around the origin
+	raylib::Vector3 Offset() const
+	{
+		return raylib::Vector3 { -gridSize[0] * 0.5f, -gridSize[1] * 0.5f, -gridSize[2] * 0.5f };
 	}
 
-	void RenderCube(float x, float y, float z, const raylib::Color& color)
+	Extent LevelSize(int level) const
 	{
-		raylib::DrawCube(raylib::Vector3 { x, y, z }, 1.0f, 1.0f, 1.0f, color);
+		Extent size;
+		for(int a = 0; a < 3; a++)
+		{
+			size[a] = (gridSize[a] + (1 << level) - 1) >> level;
+		}
+		return size;
 	}
 
-	void RenderQuad(float x, float y, float z, const raylib::Color& color)
+	const std::vector<raylib::Color>& LevelColors(int level) const
 	{
-		static uint8_t image2x2White[4] = { 255, 255, 255, 255 };
-		static raylib::Texture2D tex = raylib::LoadTextureFromImage(raylib::Image { &image2x2White, 2, 2, 1, raylib::PixelFormat::PIXELFORMAT_UNCOMPRESSED_GRAYSCALE });
+		return level == 0 ? colors : lodColors[level - 1];
+	}
 
-		raylib::DrawBillboard(cam, tex, raylib::Vector3 { x, y, z }, 1.0f, color);
+	void CreateChunks()
+	{
+		static_assert(RENDERER_CHUNK_SIZE % (1 << (RENDERER_LOD_LEVELS - 1)) == 0, "Chunks must consist of whole blocks on every level");
+		for(int d = 0; d < 3; d++)
+		{
+			chunksPerAxis[d] = (gridSize[d] + RENDERER_CHUNK_SIZE - 1) / RENDERER_CHUNK_SIZE;
+		}
+		chunks = std::vector<RenderChunk>(chunksPerAxis[0] * chunksPerAxis[1] * chunksPerAxis[2]);
+		for(int i = 0; i < static_cast<int>(chunks.size()); i++)
+		{
+			RenderChunk& chunk = chunks[i];
+			int c[3] = { i % chunksPerAxis[0], (i / chunksPerAxis[0]) % chunksPerAxis[1], i / (chunksPerAxis[0] * chunksPerAxis[1]) };
+			for(int d = 0; d < 3; d++)
+			{
+				chunk.from[d] = c[d] * RENDERER_CHUNK_SIZE;
+				chunk.to[d] = std::min(chunk.from[d] + RENDERER_CHUNK_SIZE, gridSize[d]);
+			}
+			for(int level = 0; level < RENDERER_LOD_LEVELS; level++)
+			{
+				chunk.meshes[level] = std::make_unique<BatchMesh>();
+				chunk.dirty[level] = true;
+			}
+			chunk.pyramidDirty = true;
+			chunk.visible = true;
+			chunk.level = 0;
+		}
 	}
 
-	void RenderPoint(float x, float y, float z, const raylib::Color& color)
+	//Marks the chunks whose mesh depends on the cell as dirty
+	//On level k these are the chunks of all cells within 2^k cells along each axis, since the cell influences the faces of the neighbouring blocks
+	void MarkChunksDirty(int x, int y, int z)
 	{
-		raylib::DrawLine3D(raylib::Vector3 { x - 0.1f, y, z }, raylib::Vector3 { x + 0.1f, y, z }, color);
-		raylib::DrawLine3D(raylib::Vector3 { x, y - 0.1f, z }, raylib::Vector3 { x, y + 0.1f, z }, color);
-		raylib::DrawLine3D(raylib::Vector3 { x, y, z - 0.1f }, raylib::Vector3 { x, y, z + 0.1f }, color);
+		ChunkAt(x, y, z).pyramidDirty = true;
+		for(int level = 0; level < RENDERER_LOD_LEVELS; level++)
+		{
+			int d = 1 << level;
+			int offsets[7][3] = { { 0, 0, 0 }, { d, 0, 0 }, { -d, 0, 0 }, { 0, d, 0 }, { 0, -d, 0 }, { 0, 0, d }, { 0, 0, -d } };
+			for(const int* o : offsets)
+			{
+				int nx = x + o[0];
+				int ny = y + o[1];
+				int nz = z + o[2];
+				if(nx < 0 || nx >= gridSize[0] || ny < 0 || ny >= gridSize[1] || nz < 0 || nz >= gridSize[2])
+				{
+					continue;
+				}
+				ChunkAt(nx, ny, nz).dirty[level] = true;
+			}
+		}
 	}
 
-	raylib::Color ColorState(int dimSize, int x, int y, int z, float t, const std::vector<raylib::Color>& gradient)
+	RenderChunk& ChunkAt(int x, int y, int z)
 	{
-		return gradient[static_cast<int>(std::floor(t * (gradient.size() - 1)))];
+		int cx = x / RENDERER_CHUNK_SIZE;
+		int cy = y / RENDERER_CHUNK_SIZE;
+		int cz = z / RENDERER_CHUNK_SIZE;
+		return chunks[(cz * chunksPerAxis[0] * chunksPerAxis[1]) + (cy * chunksPerAxis[0]) + cx];
 	}
 
-	raylib::Color ColorXYZ(int dimSize, int x, int y, int z, float t, const std::vector<raylib::Color>& gradient)
+	//Downsamples the region of a chunk into all coarser levels
+	//A block is non empty if the majority of its cells is non empty and gets the average color of those cells
+	void UpdatePyramid(RenderChunk& chunk)
 	{
-		float dimSizeMinusOne = dimSize - 1.0f;
-		unsigned char r = static_cast<unsigned char>(std::floor(x / dimSizeMinusOne * 255.0f));
-		unsigned char g = static_cast<unsigned char>(std::floor(y / dimSizeMinusOne * 255.0f));
-		unsigned char b = static_cast<unsigned char>(std::floor(z / dimSizeMinusOne * 255.0f));
-		return raylib::Color { r, g, b, 255 };
+		chunk.pyramidDirty = false;
+		for(int level = 1; level < RENDERER_LOD_LEVELS; level++)
+		{
+			int blockSize = 1 << level;
+			Extent levelSize = LevelSize(level);
+			std::vector<raylib::Color>& levelColors = lodColors[level - 1];
+			for(int bz = chunk.from[2] / blockSize; bz * blockSize < chunk.to[2]; bz++)
+			{
+				for(int by = chunk.from[1] / blockSize; by * blockSize < chunk.to[1]; by++)
+				{
+					for(int bx = chunk.from[0] / blockSize; bx * blockSize < chunk.to[0]; bx++)
+					{
+						int total = 0;
+						int filled = 0;
+						int sum[4] = { 0, 0, 0, 0 };
+						for(int z = bz * blockSize; z < std::min((bz + 1) * blockSize, gridSize[2]); z++)
+						{
+							for(int y = by * blockSize; y < std::min((by + 1) * blockSize, gridSize[1]); y++)
+							{
+								for(int x = bx * blockSize; x < std::min((bx + 1) * blockSize, gridSize[0]); x++)
+								{
+									const raylib::Color& c = colors[(z * gridSize[0] * gridSize[1]) + (y * gridSize[0]) + x];
+									total++;
+									if(c.a != 0)
+									{
+										filled++;
+										sum[0] += c.r;
+										sum[1] += c.g;
+										sum[2] += c.b;
+										sum[3] += c.a;
+									}
+								}
+							}
+						}
+						raylib::Color& block = levelColors[(bz * levelSize[0] * levelSize[1]) + (by * levelSize[0]) + bx];
+						if(filled * 2 > total)
+						{
+							block = raylib::Color { static_cast<unsigned char>(sum[0] / filled), static_cast<unsigned char>(sum[1] / filled), static_cast<unsigned char>(sum[2] / filled), static_cast<unsigned char>(sum[3] / filled) };
+						}
+						else
+						{
+							block = raylib::Color { 0, 0, 0, 0 };
+						}
+					}
+				}
+			}
+		}
 	}
 
-	raylib::Color ColorRadius(int dimSize, int x, int y, int z, float t, const std::vector<raylib::Color>& gradient)
+	//Adjusts the level of detail bias, so that the frame time stays close to the target frame time
+	void UpdateLodBias()
 	{
-		static const float sqrt3 = std::sqrtf(3.0f);
-		float center = dimSize * 0.5f;
-		t = std::clamp((std::abs(x - center) + std::abs(y - center) + std::abs(z - center)) / (sqrt3 * dimSize * 0.5f), 0.0f, 1.0f);
-		return gradient[static_cast<int>(std::floor(t * (gradient.size() - 1)))];
+		float budget = 1.0f / RENDERER_FPS;
+		float frameTime = raylib::GetFrameTime();
+		if(frameTime > budget * 1.2f)
+		{
+			lodBias = std::min(lodBias * 1.1f, RENDERER_LOD_MAX_BIAS);
+		}
+		else if(frameTime < budget * 1.05f)
+		{
+			lodBias = std::max(lodBias * 0.98f, 1.0f);
+		}
 	}
 
-private:
-	const raylib::Color BOUNDS_COLOR = { 245, 203, 66, 32 };
+	//Culls chunks outside of the camera frustum and picks the coarsest level on which a block still covers less than RENDERER_LOD_PIXELS * lodBias pixels
+	void SelectChunkLevels()
+	{
+		float screenHeight = static_cast<float>(GetViewportHeight());
+		Frustum frustum(cam, GetViewportWidth() / screenHeight);
+		float pixelsPerUnit = screenHeight / (2.0f * std::tan(cam.fovy * DEG2RAD * 0.5f));
+		raylib::Vector3 offset = Offset();
+		for(RenderChunk& chunk : chunks)
+		{
+			raylib::Vector3 min = { chunk.from[0] + offset.x, chunk.from[1] + offset.y, chunk.from[2] + offset.z };
+			raylib::Vector3 max = { chunk.to[0] + offset.x, chunk.to[1] + offset.y, chunk.to[2] + offset.z };
+			chunk.visible = frustum.IntersectsBox(min, max);
+			if(!chunk.visible)
+			{
+				continue;
+			}
 
-	raylib::Camera cam;
+			raylib::Vector3 center = raylib::Vector3Scale(raylib::Vector3Add(min, max), 0.5f);
+			float radius = raylib::Vector3Distance(min, max) * 0.5f;
+			float distance = std::max(raylib::Vector3Distance(cam.position, center) - radius, 1.0f);
+			float cellPixels = pixelsPerUnit / distance;
+			int level = 0;
+			while(level < RENDERER_LOD_LEVELS - 1 && cellPixels * (1 << (level + 1)) <= RENDERER_LOD_PIXELS * lodBias)
+			{
+				level++;
+			}
+			chunk.level = level;
+		}
+	}
+
+	void WriteQuad(int vertex, const RenderCell& cell)
+	{
+		batch.WriteBillboard(vertex, cell.pos, camRight, camUp, 1.0f, cell.color);
+	}
+
+	void WritePoint(int vertex, const RenderCell& cell)
+	{
+		batch.WriteCross(vertex, cell.pos, 0.1f, cell.color);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "rule.h"
+#include <regex>
+#include <string>
+
+#include "neighbourhood.h"
+
+BitMask Rule::Parse(std::string rule, NeighbourMode neighbourMode)
+{
+	std::erase(rule, ' ');
+	int maxNeighbours = Neighbourhood::Get(neighbourMode).count;
+	BitMask mask;
+	//Compiled once, matching with a const regex is thread safe
+	static const std::regex reg(R"(((\d+)-(\d+))|(\d+))");
+	std::smatch match;
+	while(std::regex_search(rule, match, reg))
+	{
+		if(match[1].str().length())
+		{
+			//Range
+			int from = std::stoi(match[2]);
+			int to = std::stoi(match[3]);
+			for(int i = from; i <= to; i++)
+			{
+				if(i >= 0 && i <= maxNeighbours)
+				{
+					mask.Set(i, true);
+				}
+			}
+		}
+		else
+		{
+			//Single int
+			int i = std::stoi(match[0]);
+			if(i >= 0 && i <= maxNeighbours)
+			{
+				mask.Set(i, true);
+			}
+		}
+		rule = match.suffix();
+	}
+	return mask;
+}
\ No newline at end of file
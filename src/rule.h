@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+#include "bitmask.h"
+#include "config.h"
+
+namespace Rule
+{
+	//Parses a list of comma separated numbers or ranges (1,2,3-5,7,10-12) into a mask of neighbour counts
+	//Counts above the amount of neighbours in the neighbourhood are ignored
+	BitMask Parse(std::string rule, NeighbourMode neighbourMode);
+}
\ No newline at end of file
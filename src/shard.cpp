@@ -0,0 +1,310 @@
+#include "shard.h"
+#include <cstring>
+#include <format>
+#include <random>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+
+#include "simulation.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <csignal>
+
+extern char** environ;
+#endif
+
+ShardWorker::ShardWorker(const StaticSimSettings& settings, uint32_t seed, int z0, int z1, HaloTransport& transport) : settings(settings), transport(transport), kernel(settings)
+{
+	depth = z1 - z0;
+	planeSize = static_cast<uint64_t>(settings.size[0]) * settings.size[0];
+	cells = std::vector<uint8_t>((depth + 2) * planeSize, 0);
+	next = std::vector<uint8_t>(depth * planeSize, 0);
+	for(int z = z0; z < z1; z++)
+	{
+		uint8_t* plane = Plane(z - z0 + 1);
+		for(int y = 0; y < settings.size[0]; y++)
+		{
+			for(int x = 0; x < settings.size[0]; x++)
+			{
+				plane[(y * settings.size[0]) + x] = FillCell(settings, seed, x, y, z);
+			}
+		}
+	}
+}
+
+bool ShardWorker::Step(PlaneKernel::Stats& stats)
+{
+	//Boundary planes of this generation to the neighbours first, so that two shards never wait on each other
+	bool lower = transport.HasNeighbour(0);
+	bool upper = transport.HasNeighbour(1);
+	if((lower && !transport.Send(0, generation, Plane(1))) || (upper && !transport.Send(1, generation, Plane(depth))))
+	{
+		return false;
+	}
+	if((lower && !transport.Receive(0, generation, Plane(0))) || (upper && !transport.Receive(1, generation, Plane(depth + 1))))
+	{
+		return false;
+	}
+
+	kernel.Begin(lower ? Plane(0) : nullptr, Plane(1));
+	for(int z = 1; z <= depth; z++)
+	{
+		kernel.Next(z < depth || upper ? Plane(z + 1) : nullptr, &next[(z - 1) * planeSize], stats);
+	}
+	std::memcpy(Plane(1), next.data(), next.size());
+	generation++;
+	return true;
+}
+
+uint64_t ShardWorker::GetGeneration() const
+{
+	return generation;
+}
+
+const uint8_t* ShardWorker::GetCells() const
+{
+	return &cells[planeSize];
+}
+
+uint64_t ShardWorker::GetCellCount() const
+{
+	return depth * planeSize;
+}
+
+PlaneKernel::Stats ShardWorker::CountCells() const
+{
+	PlaneKernel::Stats stats;
+	const uint8_t* interior = GetCells();
+	for(uint64_t i = 0; i < GetCellCount(); i++)
+	{
+		stats.population += interior[i] != 0;
+		stats.alive += interior[i] == settings.states - 1;
+	}
+	return stats;
+}
+
+uint8_t ShardWorker::FillCell(const StaticSimSettings& settings, uint32_t seed, int x, int y, int z)
+{
+	if(!Simulation::IsInFill(settings, x, y, z))
+	{
+		return 0;
+	}
+	//SplitMix64 of the seed and the index instead of a random engine, which would depend on the order of the cells
+	uint64_t h = (static_cast<uint64_t>(seed) << 32) ^ ((((static_cast<uint64_t>(z) * settings.size[0]) + y) * settings.size[0]) + x);
+	h += 0x9E3779B97F4A7C15;
+	h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9;
+	h = (h ^ (h >> 27)) * 0x94D049BB133111EB;
+	h ^= h >> 31;
+	float random = static_cast<float>(h >> 40) / static_cast<float>(1 << 24);
+	return random < settings.fillProb ? static_cast<uint8_t>(settings.states - 1) : 0;
+}
+
+uint8_t* ShardWorker::Plane(int local)
+{
+	return &cells[local * planeSize];
+}
+
+ShardCoordinator::~ShardCoordinator()
+{
+	Stop();
+}
+
+bool ShardCoordinator::Start(const std::string& program, const StaticSimSettings& settings, uint32_t seed, int shardCount)
+{
+	Stop();
+	//tmpfs on Linux, so that the region never has to be written to a disk
+	std::filesystem::path directory = std::filesystem::is_directory("/dev/shm") ? std::filesystem::path("/dev/shm") : std::filesystem::temp_directory_path();
+	path = (directory / std::format("cellularautomata_{0}.shards", std::random_device()())).string();
+	if(!region.Create(path, settings, seed, shardCount))
+	{
+		error = region.GetError();
+		path.clear();
+		return false;
+	}
+	generation = 0;
+	snapshots = 0;
+
+	for(int shard = 0; shard < shardCount; shard++)
+	{
+		if(!Launch(program, shard))
+		{
+			Stop();
+			return false;
+		}
+	}
+	return WaitForWorkers([&](int shard) { return ShardRegion::Load(region.GetStatus(shard).ready) != 0; });
+}
+
+bool ShardCoordinator::Step(int generations)
+{
+	generation += generations;
+	ShardRegion::Store(region.GetControl().targetGeneration, generation);
+	return WaitForWorkers([&](int shard) { return ShardRegion::Load(region.GetStatus(shard).generation) == generation; });
+}
+
+bool ShardCoordinator::Snapshot(std::vector<uint8_t>& cells)
+{
+	snapshots++;
+	ShardRegion::Store(region.GetControl().snapshotRequest, snapshots);
+	if(!WaitForWorkers([&](int shard) { return ShardRegion::Load(region.GetStatus(shard).snapshotDone) == snapshots; }))
+	{
+		return false;
+	}
+	uint64_t size = region.GetPlaneSize() * region.GetSettings().size[0];
+	cells.assign(region.GetSnapshot(), region.GetSnapshot() + size);
+	return true;
+}
+
+void ShardCoordinator::Stop()
+{
+	if(path.empty())
+	{
+		return;
+	}
+	ShardRegion::Store(region.GetControl().stop, 1);
+#ifdef _WIN32
+	for(void* process : processes)
+	{
+		if(WaitForSingleObject(process, 5000) == WAIT_TIMEOUT)
+		{
+			TerminateProcess(process, 1);
+		}
+		CloseHandle(process);
+	}
+#else
+	for(int process : processes)
+	{
+		if(process > 0)
+		{
+			waitpid(process, nullptr, 0);
+		}
+	}
+#endif
+	processes.clear();
+	region.Close();
+	std::error_code ignored;
+	std::filesystem::remove(path, ignored);
+	path.clear();
+}
+
+uint64_t ShardCoordinator::GetGeneration() const
+{
+	return generation;
+}
+
+PlaneKernel::Stats ShardCoordinator::GetStats()
+{
+	PlaneKernel::Stats stats;
+	for(int shard = 0; shard < region.GetShardCount(); shard++)
+	{
+		ShardRegion::WorkerStatus& status = region.GetStatus(shard);
+		stats.changed += ShardRegion::Load(status.changed);
+		stats.population += ShardRegion::Load(status.population);
+		stats.alive += ShardRegion::Load(status.alive);
+	}
+	return stats;
+}
+
+const std::string& ShardCoordinator::GetError() const
+{
+	return error;
+}
+
+#ifdef _WIN32
+bool ShardCoordinator::Launch(const std::string& program, int shard)
+{
+	char executable[MAX_PATH];
+	GetModuleFileNameA(nullptr, executable, MAX_PATH);
+	std::string commandLine = std::format("\"{0}\" --shard-worker {1} --shard-region \"{2}\"", executable, shard, path);
+	STARTUPINFOA startup = {};
+	startup.cb = sizeof(startup);
+	PROCESS_INFORMATION info = {};
+	if(!CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info))
+	{
+		error = std::format("Could not start shard worker {0} (error {1})", shard, GetLastError());
+		return false;
+	}
+	CloseHandle(info.hThread);
+	processes.push_back(info.hProcess);
+	return true;
+}
+
+bool ShardCoordinator::CheckWorkers()
+{
+	for(int shard = 0; shard < static_cast<int>(processes.size()); shard++)
+	{
+		if(ShardRegion::Load(region.GetStatus(shard).failed) != 0 || WaitForSingleObject(processes[shard], 0) == WAIT_OBJECT_0)
+		{
+			error = std::format("Shard worker {0} failed", shard);
+			return false;
+		}
+	}
+	return true;
+}
+#else
+bool ShardCoordinator::Launch(const std::string& program, int shard)
+{
+	std::string executable = std::filesystem::exists("/proc/self/exe") ? std::filesystem::read_symlink("/proc/self/exe").string() : program;
+	std::string shardArg = std::to_string(shard);
+	char* argv[] = { executable.data(), const_cast<char*>("--shard-worker"), shardArg.data(), const_cast<char*>("--shard-region"), path.data(), nullptr };
+	pid_t pid = 0;
+	int result = posix_spawnp(&pid, executable.c_str(), nullptr, nullptr, argv, environ);
+	if(result != 0)
+	{
+		error = std::format("Could not start shard worker {0} ({1})", shard, std::strerror(result));
+		return false;
+	}
+	processes.push_back(pid);
+	return true;
+}
+
+bool ShardCoordinator::CheckWorkers()
+{
+	for(int shard = 0; shard < static_cast<int>(processes.size()); shard++)
+	{
+		if(ShardRegion::Load(region.GetStatus(shard).failed) != 0 || (processes[shard] > 0 && waitpid(processes[shard], nullptr, WNOHANG) == processes[shard]))
+		{
+			processes[shard] = -1;
+			error = std::format("Shard worker {0} failed", shard);
+			return false;
+		}
+	}
+	return true;
+}
+#endif
+
+template<typename F>
+bool ShardCoordinator::WaitForWorkers(F condition)
+{
+	for(int i = 0; ; i++)
+	{
+		bool done = true;
+		for(int shard = 0; shard < region.GetShardCount() && done; shard++)
+		{
+			done = condition(shard);
+		}
+		if(done)
+		{
+			return true;
+		}
+		if(i % 1000 == 999 && !CheckWorkers())
+		{
+			return false;
+		}
+		if(i < 1000)
+		{
+			std::this_thread::yield();
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+	}
+}
\ No newline at end of file
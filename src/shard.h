@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "config.h"
+#include "planekernel.h"
+#include "halotransport.h"
+#include "shardregion.h"
+
+//Part of a grid that is split along z into shards, the planes [z0, z1) with one plane of halo on each side
+//Before each step the boundary planes are sent to the neighbouring shards and their boundary planes are received as halo
+class ShardWorker
+{
+public:
+	ShardWorker(const StaticSimSettings& settings, uint32_t seed, int z0, int z1, HaloTransport& transport);
+
+	//False if the transport was stopped
+	bool Step(PlaneKernel::Stats& stats);
+
+	uint64_t GetGeneration() const;
+	//The planes [z0, z1)
+	const uint8_t* GetCells() const;
+	uint64_t GetCellCount() const;
+	PlaneKernel::Stats CountCells() const;
+
+	//Initial state of a cell, depends only on the seed and the position so that it does not change with the amount of shards
+	static uint8_t FillCell(const StaticSimSettings& settings, uint32_t seed, int x, int y, int z);
+
+private:
+	StaticSimSettings settings;
+	HaloTransport& transport;
+	PlaneKernel kernel;
+	int depth;
+	uint64_t planeSize;
+	uint64_t generation = 0;
+	//depth + 2 planes, the first and last one are the halo
+	std::vector<uint8_t> cells;
+	std::vector<uint8_t> next;
+
+	uint8_t* Plane(int local);
+};
+
+//Runs a simulation in several worker processes of this executable (started with --shard-worker) that share a ShardRegion
+//The coordinator only sends commands and gathers statistics and snapshots, the workers exchange their halos directly
+class ShardCoordinator
+{
+public:
+	ShardCoordinator() = default;
+	~ShardCoordinator();
+
+	ShardCoordinator(const ShardCoordinator&) = delete;
+	ShardCoordinator& operator=(const ShardCoordinator&) = delete;
+
+	bool Start(const std::string& program, const StaticSimSettings& settings, uint32_t seed, int shardCount);
+	//Advances all shards and waits until they are done
+	bool Step(int generations);
+	//Copies all cells (ordered like a MappedGrid) at the current generation
+	bool Snapshot(std::vector<uint8_t>& cells);
+	void Stop();
+
+	uint64_t GetGeneration() const;
+	//Sum over all shards of the last step
+	PlaneKernel::Stats GetStats();
+	const std::string& GetError() const;
+
+private:
+	ShardRegion region;
+	std::string path;
+	uint64_t generation = 0;
+	uint64_t snapshots = 0;
+	std::string error;
+#ifdef _WIN32
+	std::vector<void*> processes;
+#else
+	std::vector<int> processes;
+#endif
+
+	bool Launch(const std::string& program, int shard);
+	//False if a worker failed or exited
+	bool CheckWorkers();
+	template<typename F>
+	bool WaitForWorkers(F condition);
+};
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "shardregion.h"
+#include <cstring>
+
+ShardRegion::~ShardRegion()
+{
+	Close();
+}
+
+bool ShardRegion::Create(const std::string& path, const StaticSimSettings& settings, uint32_t seed, int shardCount)
+{
+	Close();
+	uint64_t size = Layout(settings.size[0], shardCount);
+	if(!file.Open(path, size) || (view = file.Map(0, size)).data == nullptr)
+	{
+		error = file.GetError();
+		Close();
+		return false;
+	}
+	std::memset(view.data, 0, snapshotOffset);
+
+	Control& control = GetControl();
+	std::memcpy(control.magic, MAGIC, sizeof(MAGIC));
+	control.version = VERSION;
+	control.shardCount = shardCount;
+	control.dimSize = settings.size[0];
+	control.states = settings.states;
+	control.neighbourMode = settings.neighbourMode;
+	control.wrapSide = settings.wrap[0] ? 1 : 0;
+	control.fillShape = static_cast<uint32_t>(settings.fillShape);
+	control.fillDiameter = settings.fillDiameter;
+	control.fillProb = settings.fillProb;
+	control.seed = seed;
+	control.surviveRule = settings.surviveRule;
+	control.spawnRule = settings.spawnRule;
+	return true;
+}
+
+bool ShardRegion::Open(const std::string& path)
+{
+	Close();
+	if(!file.Open(path, 0))
+	{
+		error = file.GetError();
+		return false;
+	}
+	MappedFile::View header = file.Map(0, sizeof(Control));
+	if(header.data == nullptr)
+	{
+		error = file.GetError();
+		Close();
+		return false;
+	}
+	Control control;
+	std::memcpy(&control, header.data, sizeof(Control));
+	file.Unmap(header);
+	if(std::memcmp(control.magic, MAGIC, sizeof(MAGIC)) != 0 || control.version != VERSION)
+	{
+		error = "File is not a shard region of this version";
+		Close();
+		return false;
+	}
+
+	uint64_t size = Layout(control.dimSize, control.shardCount);
+	if(file.GetSize() < size || (view = file.Map(0, size)).data == nullptr)
+	{
+		error = file.GetSize() < size ? "Shard region is too small" : file.GetError();
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void ShardRegion::Close()
+{
+	file.Unmap(view);
+	file.Close();
+}
+
+const std::string& ShardRegion::GetError() const
+{
+	return error;
+}
+
+StaticSimSettings ShardRegion::GetSettings() const
+{
+	const Control& control = *reinterpret_cast<const Control*>(view.data);
+	StaticSimSettings settings = {};
+	settings.size = { static_cast<int>(control.dimSize), static_cast<int>(control.dimSize), static_cast<int>(control.dimSize) };
+	settings.fillShape = static_cast<FillShape>(control.fillShape);
+	settings.fillDiameter = control.fillDiameter;
+	settings.fillProb = control.fillProb;
+	settings.wrap.fill(control.wrapSide != 0);
+	settings.neighbourMode = static_cast<NeighbourMode>(control.neighbourMode);
+	settings.states = control.states;
+	for(int i = 0; i < 64; i++)
+	{
+		settings.surviveRule.Set(i, (control.surviveRule >> i) & 1);
+		settings.spawnRule.Set(i, (control.spawnRule >> i) & 1);
+	}
+	return settings;
+}
+
+uint32_t ShardRegion::GetSeed() const
+{
+	return reinterpret_cast<const Control*>(view.data)->seed;
+}
+
+int ShardRegion::GetShardCount() const
+{
+	return shardCount;
+}
+
+uint64_t ShardRegion::GetPlaneSize() const
+{
+	return planeSize;
+}
+
+void ShardRegion::GetShardRange(int shard, int& z0, int& z1) const
+{
+	z0 = static_cast<int>(static_cast<int64_t>(dimSize) * shard / shardCount);
+	z1 = static_cast<int>(static_cast<int64_t>(dimSize) * (shard + 1) / shardCount);
+}
+
+ShardRegion::Control& ShardRegion::GetControl()
+{
+	return *reinterpret_cast<Control*>(view.data);
+}
+
+ShardRegion::WorkerStatus& ShardRegion::GetStatus(int shard)
+{
+	return reinterpret_cast<WorkerStatus*>(view.data + statusOffset)[shard];
+}
+
+ShardRegion::RingHeader& ShardRegion::GetRing(int shard, int face)
+{
+	return *reinterpret_cast<RingHeader*>(view.data + ringOffset + ((shard * 2 + face) * ringSize));
+}
+
+uint8_t* ShardRegion::GetRingSlot(int shard, int face, int slot)
+{
+	uint64_t slotSize = (planeSize + 63) / 64 * 64;
+	return view.data + ringOffset + ((shard * 2 + face) * ringSize) + sizeof(RingHeader) + (slot * slotSize);
+}
+
+uint8_t* ShardRegion::GetSnapshot()
+{
+	return view.data + snapshotOffset;
+}
+
+uint64_t ShardRegion::Layout(int dimSize, int shardCount)
+{
+	this->dimSize = dimSize;
+	this->shardCount = shardCount;
+	planeSize = static_cast<uint64_t>(dimSize) * dimSize;
+	statusOffset = (sizeof(Control) + 63) / 64 * 64;
+	ringOffset = statusOffset + (shardCount * sizeof(WorkerStatus));
+	ringSize = sizeof(RingHeader) + (SHARD_RING_SLOTS * ((planeSize + 63) / 64 * 64));
+	snapshotOffset = (ringOffset + (shardCount * 2 * ringSize) + 4095) / 4096 * 4096;
+	return snapshotOffset + (planeSize * dimSize);
+}
+
+SharedMemoryTransport::SharedMemoryTransport(ShardRegion& region, int shard) : region(region), shard(shard)
+{
+	int count = region.GetShardCount();
+	bool wrap = region.GetSettings().wrap[0];
+	neighbours[0] = shard > 0 ? shard - 1 : (wrap ? count - 1 : -1);
+	neighbours[1] = shard < count - 1 ? shard + 1 : (wrap ? 0 : -1);
+}
+
+bool SharedMemoryTransport::HasNeighbour(int face) const
+{
+	return neighbours[face] >= 0;
+}
+
+bool SharedMemoryTransport::Send(int face, uint64_t generation, const uint8_t* plane)
+{
+	//The slot is free once the neighbour received the generation that was stored in it before
+	ShardRegion::RingHeader& ring = region.GetRing(shard, face);
+	if(!region.Wait([&]() { return generation < ShardRegion::Load(ring.consumed) + SHARD_RING_SLOTS; }))
+	{
+		return false;
+	}
+	int slot = static_cast<int>(generation % SHARD_RING_SLOTS);
+	std::memcpy(region.GetRingSlot(shard, face, slot), plane, region.GetPlaneSize());
+	ShardRegion::Store(ring.published[slot], generation + 1);
+	return true;
+}
+
+bool SharedMemoryTransport::Receive(int face, uint64_t generation, uint8_t* plane)
+{
+	//The neighbour below sends its highest plane and the one above its lowest
+	int neighbour = neighbours[face];
+	int neighbourFace = 1 - face;
+	ShardRegion::RingHeader& ring = region.GetRing(neighbour, neighbourFace);
+	int slot = static_cast<int>(generation % SHARD_RING_SLOTS);
+	if(!region.Wait([&]() { return ShardRegion::Load(ring.published[slot]) == generation + 1; }))
+	{
+		return false;
+	}
+	std::memcpy(plane, region.GetRingSlot(neighbour, neighbourFace, slot), region.GetPlaneSize());
+	ShardRegion::Store(ring.consumed, generation + 1);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "config.h"
+#include "mappedfile.h"
+#include "halotransport.h"
+
+//Memory shared by the coordinator and the worker processes of a sharded simulation, backed by a mapped file
+//Contains the settings and commands of the coordinator, the status of each worker, one ring buffer of planes per face of each shard and room for a snapshot of the whole grid
+//Values that are written by one process and read by another are only accessed through Load and Store
+//Like MappedGrid, sharded grids are cubes that wrap around along all axes or none
+class ShardRegion
+{
+public:
+	struct Control
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t shardCount;
+		uint32_t dimSize;
+		uint32_t states;
+		uint32_t neighbourMode;
+		uint32_t wrapSide;
+		uint32_t fillShape;
+		float fillDiameter;
+		float fillProb;
+		uint32_t seed;
+		uint64_t surviveRule;
+		uint64_t spawnRule;
+		//Commands, workers step until they reach targetGeneration and write their planes to the snapshot whenever snapshotRequest changes
+		uint64_t targetGeneration;
+		uint64_t snapshotRequest;
+		uint64_t stop;
+	};
+
+	//Written by one worker, generation is stored last
+	struct alignas(64) WorkerStatus
+	{
+		uint64_t generation;
+		uint64_t population;
+		uint64_t alive;
+		uint64_t changed;
+		uint64_t snapshotDone;
+		uint64_t ready;
+		uint64_t failed;
+	};
+
+	//published[slot] is generation + 1 of the plane in the slot, consumed the amount of generations the reader received
+	struct alignas(64) RingHeader
+	{
+		uint64_t consumed;
+		uint64_t published[SHARD_RING_SLOTS];
+	};
+
+	ShardRegion() = default;
+	~ShardRegion();
+
+	ShardRegion(const ShardRegion&) = delete;
+	ShardRegion& operator=(const ShardRegion&) = delete;
+
+	//Called by the coordinator
+	bool Create(const std::string& path, const StaticSimSettings& settings, uint32_t seed, int shardCount);
+	//Called by the workers
+	bool Open(const std::string& path);
+	void Close();
+	const std::string& GetError() const;
+
+	StaticSimSettings GetSettings() const;
+	uint32_t GetSeed() const;
+	int GetShardCount() const;
+	uint64_t GetPlaneSize() const;
+	//The shard simulates the planes [z0, z1)
+	void GetShardRange(int shard, int& z0, int& z1) const;
+
+	Control& GetControl();
+	WorkerStatus& GetStatus(int shard);
+	RingHeader& GetRing(int shard, int face);
+	uint8_t* GetRingSlot(int shard, int face, int slot);
+	//dimSize^3 cells ordered like a MappedGrid
+	uint8_t* GetSnapshot();
+
+	static uint64_t Load(uint64_t& value)
+	{
+		return std::atomic_ref<uint64_t>(value).load(std::memory_order_acquire);
+	}
+
+	static void Store(uint64_t& value, uint64_t newValue)
+	{
+		std::atomic_ref<uint64_t>(value).store(newValue, std::memory_order_release);
+	}
+
+	//Waits until condition() returns true (true) or the coordinator stopped the simulation (false)
+	//Spins for a short time first, since the other side usually only needs a few microseconds
+	template<typename F>
+	bool Wait(F condition)
+	{
+		for(int i = 0; ; i++)
+		{
+			if(condition())
+			{
+				return true;
+			}
+			if(Load(GetControl().stop) != 0)
+			{
+				return false;
+			}
+			if(i < 1000)
+			{
+				std::this_thread::yield();
+			}
+			else
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
+	}
+
+private:
+	static constexpr char MAGIC[8] = { 'C', 'A', '3', 'D', 'S', 'H', 'R', 'D' };
+	static const uint32_t VERSION = 1;
+
+	MappedFile file;
+	MappedFile::View view;
+	std::string error;
+	int shardCount = 0;
+	int dimSize = 0;
+	uint64_t planeSize = 0;
+	uint64_t statusOffset = 0;
+	uint64_t ringOffset = 0;
+	uint64_t ringSize = 0;
+	uint64_t snapshotOffset = 0;
+
+	//Computes the offsets of all parts and returns the size of the region
+	uint64_t Layout(int dimSize, int shardCount);
+};
+
+//HaloTransport between worker processes on the same machine through the rings of a ShardRegion
+class SharedMemoryTransport : public HaloTransport
+{
+public:
+	SharedMemoryTransport(ShardRegion& region, int shard);
+
+	bool HasNeighbour(int face) const override;
+	bool Send(int face, uint64_t generation, const uint8_t* plane) override;
+	bool Receive(int face, uint64_t generation, uint8_t* plane) override;
+
+private:
+	ShardRegion& region;
+	int shard;
+	//Shard below and above, -1 if there is none
+	int neighbours[2];
+};
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "simulation.h"
+#include <cmath>
+#include <exception>
+#include <chrono>
+#include <algorithm>
+
+#define RAYGUI_STATIC
+#include "raylibinclude.h"
+
+Simulation::Simulation(const StaticSimSettings& settings, uint32_t seed) : settings(settings), grid(settings.size, settings.wrap, settings.neighbourMode, IntCell(0, settings.states - 1)), randEngine(seed), updateKey(seed)
+{
+	Fill();
+}
+
+void Simulation::Step()
+{
+	Step(1);
+}
+
+bool Simulation::StepPart(int planes)
+{
+	//The symmetric domain is small enough to be stepped at once
+	if(UpdateSymmetry())
+	{
+		Step();
+		return true;
+	}
+	//Cells of asynchronous steps depend on the cells updated before them, so the step is not split
+	if(settings.updateMode == UpdateMode::Asynchronous)
+	{
+		Step();
+		return true;
+	}
+	//A step that is already partly computed is finished in the same way
+	if(grid.GetTransformProgress() == 0.0f)
+	{
+		partWay = SelectWay(1);
+	}
+	//Active steps only compute a small part of the grid, so they are not split
+	if(partWay != EngineSelector::Dense)
+	{
+		StepWith(partWay, 1, GRID_BLOCK_SLAB_SIZE);
+		return true;
+	}
+
+	const Extent& size = grid.GetSize();
+	int done = static_cast<int>(std::round(grid.GetTransformProgress() * size[2]));
+	auto tStart = std::chrono::high_resolution_clock::now();
+	bool complete = grid.TransformPart([this](const IntCell& cell, int neighbours) { return Next(cell, neighbours); }, planes);
+	double cells = static_cast<double>(std::min(std::max(planes, 1), size[2] - done)) * size[0] * size[1];
+	selector.Record(EngineSelector::Dense, cells, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count());
+	if(!complete)
+	{
+		return false;
+	}
+	Stepped(StepEngine::Dense, 1);
+	return true;
+}
+
+void Simulation::Step(int generations, int slabSize)
+{
+	if(UpdateSymmetry())
+	{
+		//The full grid is only needed once it is read
+		for(int i = 0; i < generations; i++)
+		{
+			symmetric->Step();
+		}
+		gridStale = true;
+		Stepped(StepEngine::Symmetric, generations);
+		return;
+	}
+	if(settings.updateMode == UpdateMode::Asynchronous)
+	{
+		for(int i = 0; i < generations; i++)
+		{
+			grid.TransformAsync([this](const IntCell& cell, int neighbours) { return Next(cell, neighbours); }, CounterRng::Get(updateKey, generation + i), settings.updateProb);
+		}
+		Stepped(StepEngine::Dense, generations);
+		return;
+	}
+	StepWith(SelectWay(generations), generations, slabSize);
+}
+
+Grid3d<IntCell>& Simulation::GetGrid()
+{
+	ExpandGrid();
+	return grid;
+}
+
+const Grid3d<IntCell>& Simulation::GetGrid() const
+{
+	ExpandGrid();
+	return grid;
+}
+
+const StaticSimSettings& Simulation::GetSettings() const
+{
+	return settings;
+}
+
+int Simulation::GetGeneration() const
+{
+	return generation;
+}
+
+void Simulation::SetGeneration(int generation)
+{
+	this->generation = generation;
+}
+
+int Simulation::GetSymmetryOrder() const
+{
+	return symmetric != nullptr ? symmetric->GetSymmetry().GetOrder() : 1;
+}
+
+StepEngine Simulation::GetEngine() const
+{
+	return engine;
+}
+
+int Simulation::GetEngineSteps(StepEngine engine) const
+{
+	return engineSteps[static_cast<int>(engine)];
+}
+
+IntCell Simulation::AliveCell() const
+{
+	return IntCell(settings.states - 1, settings.states - 1);
+}
+
+IntCell Simulation::EmptyCell() const
+{
+	return IntCell(0, settings.states - 1);
+}
+
+int Simulation::NextState(const StaticSimSettings& settings, int state, int neighbours)
+{
+	if(state == settings.states - 1)
+	{
+		return settings.surviveRule[neighbours] ? state : state - 1;
+	}
+	else if(state == 0)
+	{
+		return settings.spawnRule[neighbours] ? settings.states - 1 : 0;
+	}
+	return state - 1;
+}
+
+bool Simulation::IsInFill(const StaticSimSettings& settings, int x, int y, int z)
+{
+	raylib::Vector3 center = { settings.size[0] * 0.5f - 0.01f, settings.size[1] * 0.5f - 0.01f, settings.size[2] * 0.5f - 0.01f };
+	raylib::Vector3 p = { static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) };
+	float diameter = settings.fillDiameter;
+	switch(settings.fillShape)
+	{
+		case FillShape::Cube:
+			return (std::abs(p.x - center.x) < diameter * 0.5f && std::abs(p.y - center.y) < diameter * 0.5f && std::abs(p.z - center.z) < diameter * 0.5f);
+		case FillShape::Sphere:
+			return (std::sqrtf((p.x - center.x) * (p.x - center.x)) + std::sqrtf((p.y - center.y) * (p.y - center.y)) + std::sqrtf((p.z - center.z) * (p.z - center.z))) < diameter * 0.5f;
+		default:
+			throw std::exception("Missing switch label in Simulation::IsInFill!");
+	}
+}
+
+IntCell Simulation::Next(const IntCell& cell, int neighbours) const
+{
+	return cell.WithValue(NextState(settings, cell, neighbours));
+}
+
+EngineSelector::Way Simulation::SelectWay(int generations)
+{
+	switch(settings.engine)
+	{
+		case StepEngine::Dense:
+		case StepEngine::Symmetric:
+			return generations == 1 ? EngineSelector::Dense : EngineSelector::Blocked;
+		case StepEngine::Active:
+			return EngineSelector::Active;
+		case StepEngine::Auto:
+		{
+			//The active region may grow during the generations, so its size is only an estimate for more than one generation
+			double cells = static_cast<double>(grid.GetCellCount()) * generations;
+			return selector.Select({ cells, generations > 1 ? cells : -1.0, static_cast<double>(grid.CountActiveCells()) * generations });
+		}
+		default:
+			throw std::exception("Missing switch label in Simulation::SelectWay!");
+	}
+}
+
+void Simulation::StepWith(EngineSelector::Way way, int generations, int slabSize)
+{
+	auto next = [this](const IntCell& cell, int neighbours) { return Next(cell, neighbours); };
+	double cells = static_cast<double>(grid.GetCellCount()) * generations;
+	auto tStart = std::chrono::high_resolution_clock::now();
+	switch(way)
+	{
+		case EngineSelector::Dense:
+			for(int i = 0; i < generations; i++)
+			{
+				grid.Transform(next);
+			}
+			break;
+		case EngineSelector::Blocked:
+			grid.TransformBlocked(next, generations, slabSize);
+			break;
+		case EngineSelector::Active:
+			cells = 0.0;
+			for(int i = 0; i < generations; i++)
+			{
+				cells += grid.TransformActive(next);
+			}
+			break;
+		default:
+			throw std::exception("Missing switch label in Simulation::StepWith!");
+	}
+	selector.Record(way, cells, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count());
+	Stepped(way == EngineSelector::Active ? StepEngine::Active : StepEngine::Dense, generations);
+}
+
+void Simulation::Stepped(StepEngine engine, int generations)
+{
+	this->engine = engine;
+	engineSteps[static_cast<int>(engine)] += generations;
+	generation += generations;
+	stepRevision = grid.GetRevision();
+}
+
+void Simulation::Fill()
+{
+	//Along x first, then y and then z like the cells are stored, MappedGrid::Create draws the random numbers in the same order
+	for(int z = 0; z < settings.size[2]; z++)
+	{
+		for(int y = 0; y < settings.size[1]; y++)
+		{
+			for(int x = 0; x < settings.size[0]; x++)
+			{
+				if(IsInFill(settings, x, y, z))
+				{
+					grid.SetCell(x, y, z, RandomF01() < settings.fillProb ? AliveCell() : EmptyCell());
+				}
+			}
+		}
+	}
+	grid.UpdateNeighbours();
+}
+
+float Simulation::RandomF01()
+{
+	return std::uniform_real_distribution<float>(0.0f, 1.0f)(randEngine);
+}
+
+void Simulation::ExpandGrid() const
+{
+	if(!gridStale)
+	{
+		return;
+	}
+	gridStale = false;
+	symmetric->Expand(grid);
+	//The expanded grid is the result of the last step and still has its symmetry
+	stepRevision = grid.GetRevision();
+}
+
+bool Simulation::UpdateSymmetry()
+{
+	//Random updates do not keep the symmetry
+	if((settings.engine != StepEngine::Auto && settings.engine != StepEngine::Symmetric) || settings.updateMode == UpdateMode::Asynchronous)
+	{
+		return false;
+	}
+	//Steps keep the symmetry (or the lack of it), so it only has to be detected again after changes from outside
+	if(grid.GetRevision() != stepRevision)
+	{
+		SymmetricGrid::Symmetry symmetry = SymmetricGrid::Detect(grid);
+		symmetric = symmetry.GetOrder() > 1 ? std::make_unique<SymmetricGrid>(settings, symmetry, grid) : nullptr;
+		stepRevision = grid.GetRevision();
+	}
+	return symmetric != nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include <random>
+#include <memory>
+#include <cstdint>
+#include <array>
+
+#include "config.h"
+#include "grid3d.h"
+#include "intcell.h"
+#include "symmetricgrid.h"
+#include "engineselector.h"
+
+//Self contained simulation with its own grid, rules, random engine and generation counter
+//Instances do not share any state, so different instances can be stepped concurrently
+class Simulation
+{
+public:
+	//Fills the grid according to the settings, the seed determines the initial cells
+	Simulation(const StaticSimSettings& settings, uint32_t seed);
+
+	//Simulates a single step with the engine and update mode of the settings (see StepEngine, UpdateMode)
+	void Step();
+	//Simulates a part of a single step, at most the given amount of z-planes per call (see Grid3d::TransformPart)
+	//Returns true once the step is complete, the grid keeps the previous generation until then
+	bool StepPart(int planes);
+	//Simulates the given amount of steps at once, for when the steps in between are not needed
+	//The Dense engine uses Grid3d::TransformBlocked for this, which Auto also considers
+	void Step(int generations, int slabSize = GRID_BLOCK_SLAB_SIZE);
+
+	//Steps of the Symmetric engine only update the fundamental domain, the grid is expanded from it when it is read the next time
+	//So a reference to the grid is only up to date until the next step, and GetGrid is not thread safe even if const
+	Grid3d<IntCell>& GetGrid();
+	const Grid3d<IntCell>& GetGrid() const;
+	const StaticSimSettings& GetSettings() const;
+	int GetGeneration() const;
+	//Used when the grid is replaced by an earlier or later generation
+	void SetGeneration(int generation);
+
+	//Amount of symmetric copies of the part of the grid that is simulated, 1 if the whole grid is simulated
+	int GetSymmetryOrder() const;
+	//Engine that computed the last step, Auto before the first step
+	StepEngine GetEngine() const;
+	//Amount of steps that the engine computed so far
+	int GetEngineSteps(StepEngine engine) const;
+
+	IntCell AliveCell() const;
+	IntCell EmptyCell() const;
+
+	//Next state (0 = empty, states - 1 = alive) of a cell with the rules of settings
+	static int NextState(const StaticSimSettings& settings, int state, int neighbours);
+	//True if the cell is inside of the fill shape, where the initial cells are placed
+	static bool IsInFill(const StaticSimSettings& settings, int x, int y, int z);
+
+private:
+	StaticSimSettings settings;
+	//Mutable, since const reads expand pending symmetric steps
+	mutable Grid3d<IntCell> grid;
+	//True if symmetric has steps that were not expanded into grid yet
+	mutable bool gridStale = false;
+	std::default_random_engine randEngine;
+	//Key of the random numbers of asynchronous steps, which are drawn per generation and cell (see CounterRng)
+	uint64_t updateKey;
+	int generation = 0;
+	std::unique_ptr<SymmetricGrid> symmetric;
+	EngineSelector selector;
+	//Way of the step that StepPart is computing
+	EngineSelector::Way partWay = EngineSelector::Dense;
+	StepEngine engine = StepEngine::Auto;
+	std::array<int, 4> engineSteps = {};
+	//Revision of the grid after the last step, the grid was changed from outside (e.g. edited or restored) if it differs
+	mutable uint64_t stepRevision = 0;
+
+	IntCell Next(const IntCell& cell, int neighbours) const;
+	//Way to compute the given amount of generations on the whole grid, forced by the settings or estimated to be the cheapest
+	EngineSelector::Way SelectWay(int generations);
+	//Computes the generations on the whole grid and records the time it took for the selector
+	void StepWith(EngineSelector::Way way, int generations, int slabSize);
+	void Stepped(StepEngine engine, int generations);
+	void Fill();
+	float RandomF01();
+	//Writes the cells of the symmetric domain to grid, if it has steps the grid does not have yet
+	void ExpandGrid() const;
+	//Detects the symmetry of the grid again if it was changed from outside, returns true if the symmetric grid can be used
+	bool UpdateSymmetry();
+};
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "stream.h"
+#include <cstring>
+#include <algorithm>
+
+#include "magic_enum.hpp"
+
+namespace Stream
+{
+	static const char MAGIC[4] = { 'C', 'A', '3', 'S' };
+	//Largest payload a viewer accepts, a keyframe of the largest grid where every cell differs from its neighbour
+	static const uint64_t MAX_PAYLOAD_SIZE = static_cast<uint64_t>(SIM_MAX_DIM_SIZE) * SIM_MAX_DIM_SIZE * SIM_MAX_DIM_SIZE * 6;
+
+	static void WriteVarint(std::vector<uint8_t>& out, uint32_t value)
+	{
+		while(value >= 0x80)
+		{
+			out.push_back(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	static bool ReadVarint(const std::vector<uint8_t>& in, size_t& pos, uint32_t& value)
+	{
+		value = 0;
+		for(int shift = 0; shift < 35 && pos < in.size(); shift += 7)
+		{
+			uint8_t b = in[pos++];
+			value |= static_cast<uint32_t>(b & 0x7F) << shift;
+			if((b & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//Reserves space for the header, which is filled in by Finish once the payload size is known
+	static std::vector<uint8_t> Begin()
+	{
+		return std::vector<uint8_t>(sizeof(Header), 0);
+	}
+
+	static void Finish(std::vector<uint8_t>& out, MessageType type, const Grid3d<IntCell>& grid, const StaticSimSettings& settings, int generation)
+	{
+		Header header;
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.type = type;
+		header.states = static_cast<uint8_t>(settings.states);
+		header.neighbourMode = static_cast<uint8_t>(settings.neighbourMode);
+		header.wrap = 0;
+		for(int a = 0; a < 3; a++)
+		{
+			header.wrap |= grid.GetWrap()[a] ? (1 << a) : 0;
+			header.size[a] = static_cast<uint32_t>(grid.GetSize()[a]);
+		}
+		header.generation = static_cast<uint32_t>(generation);
+		header.payloadSize = static_cast<uint32_t>(out.size() - sizeof(Header));
+		std::memcpy(out.data(), &header, sizeof(Header));
+	}
+
+	std::vector<uint8_t> EncodeKeyframe(const Grid3d<IntCell>& grid, const StaticSimSettings& settings, int generation)
+	{
+		std::vector<uint8_t> out = Begin();
+		int count = grid.GetCellCount();
+		for(int i = 0; i < count;)
+		{
+			int state = static_cast<int>(grid[i]);
+			int run = 1;
+			while(i + run < count && static_cast<int>(grid[i + run]) == state)
+			{
+				run++;
+			}
+			WriteVarint(out, static_cast<uint32_t>(run));
+			out.push_back(static_cast<uint8_t>(state));
+			i += run;
+		}
+		Finish(out, MessageType::Keyframe, grid, settings, generation);
+		return out;
+	}
+
+	std::vector<uint8_t> EncodeDelta(const Grid3d<IntCell>& grid, const StaticSimSettings& settings, int generation)
+	{
+		//Edits can list a cell more than once and in any order, the gaps need unique ascending indices
+		std::vector<int> changes = grid.GetChanges();
+		std::sort(changes.begin(), changes.end());
+		changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+
+		std::vector<uint8_t> out = Begin();
+		int prev = -1;
+		for(int index : changes)
+		{
+			WriteVarint(out, static_cast<uint32_t>(index - prev));
+			out.push_back(static_cast<uint8_t>(static_cast<int>(grid[index])));
+			prev = index;
+		}
+		Finish(out, MessageType::Delta, grid, settings, generation);
+		return out;
+	}
+
+	bool Check(const Header& header)
+	{
+		return std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+			&& (header.type == MessageType::Keyframe || header.type == MessageType::Delta)
+			&& magic_enum::enum_contains<NeighbourMode>(header.neighbourMode)
+			&& header.states >= 2 && header.states <= SIM_MAX_STATES
+			&& std::all_of(std::begin(header.size), std::end(header.size), [](uint32_t size) { return size >= 1 && size <= static_cast<uint32_t>(SIM_MAX_DIM_SIZE); })
+			&& header.wrap < 8
+			&& header.payloadSize <= MAX_PAYLOAD_SIZE;
+	}
+
+	Extent GetSize(const Header& header)
+	{
+		return Extent { static_cast<int>(header.size[0]), static_cast<int>(header.size[1]), static_cast<int>(header.size[2]) };
+	}
+
+	AxisWrap GetWrap(const Header& header)
+	{
+		return AxisWrap { (header.wrap & 1) != 0, (header.wrap & 2) != 0, (header.wrap & 4) != 0 };
+	}
+
+	bool DecodeKeyframe(const Message& message, std::vector<IntCell>& cells)
+	{
+		const Header& header = message.header;
+		size_t count = static_cast<size_t>(header.size[0]) * header.size[1] * header.size[2];
+		cells.clear();
+		cells.reserve(count);
+		size_t pos = 0;
+		uint32_t run;
+		while(pos < message.payload.size())
+		{
+			if(!ReadVarint(message.payload, pos, run) || pos >= message.payload.size() || cells.size() + run > count || message.payload[pos] >= header.states)
+			{
+				return false;
+			}
+			cells.insert(cells.end(), run, IntCell(message.payload[pos++], header.states - 1));
+		}
+		return cells.size() == count;
+	}
+
+	bool DecodeDelta(const Message& message, std::vector<std::pair<int, IntCell>>& edits)
+	{
+		const Header& header = message.header;
+		int64_t count = static_cast<int64_t>(header.size[0]) * header.size[1] * header.size[2];
+		edits.clear();
+		size_t pos = 0;
+		int64_t index = -1;
+		uint32_t gap;
+		while(pos < message.payload.size())
+		{
+			if(!ReadVarint(message.payload, pos, gap) || pos >= message.payload.size() || (index += gap) >= count || message.payload[pos] >= header.states)
+			{
+				return false;
+			}
+			edits.push_back(std::pair<int, IntCell>(static_cast<int>(index), IntCell(message.payload[pos++], header.states - 1)));
+		}
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include "config.h"
+#include "grid3d.h"
+#include "intcell.h"
+
+//Messages sent from a stream server (--serve) to its viewers (--view)
+//A keyframe contains all cells (run length encoded states), a delta only the cells that changed in one generation (gap encoded indices + new states)
+//Server and viewers run on the same machine, so the header is sent in the native byte order
+namespace Stream
+{
+	enum class MessageType : uint8_t
+	{
+		Keyframe = 0,
+		Delta = 1
+	};
+
+	struct Header
+	{
+		char magic[4];
+		MessageType type;
+		uint8_t states;
+		uint8_t neighbourMode;
+		//Bit a is set if the cells wrap around along axis a
+		uint8_t wrap;
+		uint32_t size[3];
+		uint32_t generation;
+		uint32_t payloadSize;
+	};
+
+	struct Message
+	{
+		Header header;
+		std::vector<uint8_t> payload;
+	};
+
+	std::vector<uint8_t> EncodeKeyframe(const Grid3d<IntCell>& grid, const StaticSimSettings& settings, int generation);
+	//Only valid if the last modification of the grid was the step to generation, i.e. grid.GetChanges() are the cells that changed in this step
+	std::vector<uint8_t> EncodeDelta(const Grid3d<IntCell>& grid, const StaticSimSettings& settings, int generation);
+
+	//False if the header does not belong to a valid message
+	bool Check(const Header& header);
+	Extent GetSize(const Header& header);
+	AxisWrap GetWrap(const Header& header);
+	//False if the payload is corrupt
+	bool DecodeKeyframe(const Message& message, std::vector<IntCell>& cells);
+	bool DecodeDelta(const Message& message, std::vector<std::pair<int, IntCell>>& edits);
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "streamclient.h"
+
+StreamClient::~StreamClient()
+{
+	socket.Shutdown();
+	if(reader.joinable())
+	{
+		reader.join();
+	}
+}
+
+bool StreamClient::Connect(const std::string& path)
+{
+	if(!socket.Connect(path))
+	{
+		error = socket.GetError();
+		return false;
+	}
+	connected = true;
+	reader = std::thread(&StreamClient::Receive, this);
+	return true;
+}
+
+bool StreamClient::Update()
+{
+	std::deque<Stream::Message> messages;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::swap(messages, pending);
+	}
+
+	bool changed = false;
+	for(const Stream::Message& message : messages)
+	{
+		const Stream::Header& header = message.header;
+		if(header.type == Stream::MessageType::Keyframe)
+		{
+			if(!Stream::DecodeKeyframe(message, cells))
+			{
+				continue;
+			}
+			if(grid == nullptr || Stream::GetSize(header) != Stream::GetSize(layout) || header.wrap != layout.wrap || header.neighbourMode != layout.neighbourMode || header.states != layout.states)
+			{
+				grid = std::make_unique<Grid3d<IntCell>>(Stream::GetSize(header), Stream::GetWrap(header), static_cast<NeighbourMode>(header.neighbourMode), IntCell(0, header.states - 1));
+				layout = header;
+			}
+			grid->Load(cells);
+			generation = header.generation;
+			changed = true;
+		}
+		//A delta that does not follow the current generation belongs to a stream that this client partly missed, which ends with the next keyframe
+		else if(grid != nullptr && static_cast<int>(header.generation) == generation + 1 && Stream::DecodeDelta(message, edits))
+		{
+			grid->SetCells(edits);
+			generation++;
+			changed = true;
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stats.skipped++;
+		}
+	}
+	return changed;
+}
+
+const Grid3d<IntCell>* StreamClient::GetGrid() const
+{
+	return grid.get();
+}
+
+bool StreamClient::IsConnected() const
+{
+	return connected;
+}
+
+int StreamClient::GetGeneration() const
+{
+	return generation;
+}
+
+StreamClient::Stats StreamClient::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+const std::string& StreamClient::GetError() const
+{
+	return error;
+}
+
+void StreamClient::Receive()
+{
+	while(true)
+	{
+		Stream::Message message;
+		if(!socket.Receive(reinterpret_cast<uint8_t*>(&message.header), sizeof(Stream::Header)) || !Stream::Check(message.header))
+		{
+			break;
+		}
+		message.payload.resize(message.header.payloadSize);
+		if(!socket.Receive(message.payload.data(), message.payload.size()))
+		{
+			break;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.bytesReceived += sizeof(Stream::Header) + message.payload.size();
+		if(message.header.type == Stream::MessageType::Keyframe)
+		{
+			stats.keyframes++;
+			stats.skipped += pending.size();
+			pending.clear();
+		}
+		else
+		{
+			stats.deltas++;
+		}
+		pending.push_back(std::move(message));
+	}
+	connected = false;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include "localsocket.h"
+#include "stream.h"
+
+//Receives the messages of a StreamServer on a background thread and applies them to a grid on the thread that renders it
+//Messages that arrive while the renderer is busy are collected, a keyframe makes all earlier messages obsolete
+class StreamClient
+{
+public:
+	struct Stats
+	{
+		uint64_t keyframes = 0;
+		uint64_t deltas = 0;
+		uint64_t bytesReceived = 0;
+		//Messages that were replaced by a later keyframe before they were applied, or deltas that did not follow the current generation
+		uint64_t skipped = 0;
+	};
+
+	StreamClient() = default;
+	~StreamClient();
+	StreamClient(const StreamClient&) = delete;
+	StreamClient& operator=(const StreamClient&) = delete;
+
+	bool Connect(const std::string& path);
+	//Applies all messages received since the last call, returns true if the grid changed
+	bool Update();
+	//Nullptr before the first keyframe, recreated by keyframes with other settings
+	const Grid3d<IntCell>* GetGrid() const;
+	//False once the server closed the connection or sent an invalid message
+	bool IsConnected() const;
+	//Generation of the grid after the last Update, -1 before the first keyframe
+	int GetGeneration() const;
+	Stats GetStats() const;
+	const std::string& GetError() const;
+
+private:
+	LocalSocket socket;
+	std::thread reader;
+	std::atomic<bool> connected = false;
+
+	mutable std::mutex mutex;
+	std::deque<Stream::Message> pending;
+	Stats stats;
+
+	std::unique_ptr<Grid3d<IntCell>> grid;
+	//Header of the keyframe the grid was created for
+	Stream::Header layout = {};
+	int generation = -1;
+	std::vector<IntCell> cells;
+	std::vector<std::pair<int, IntCell>> edits;
+	std::string error;
+
+	void Receive();
+};
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "streamserver.h"
+#include <algorithm>
+
+#include "config.h"
+#include "stream.h"
+
+bool StreamServer::Listen(const std::string& path)
+{
+	if(!listener.Listen(path))
+	{
+		error = listener.GetError();
+		return false;
+	}
+	return true;
+}
+
+void StreamServer::Accept()
+{
+	for(LocalSocket socket = listener.Accept(); socket.IsOpen(); socket = listener.Accept())
+	{
+		if(socket.SetNonBlocking())
+		{
+			viewers.emplace_back(std::move(socket));
+		}
+	}
+}
+
+void StreamServer::Publish(const Simulation& simulation)
+{
+	const Grid3d<IntCell>& grid = simulation.GetGrid();
+	bool changed = grid.GetRevision() != publishedRevision;
+	//A delta is only possible if the grid was modified once since the last published generation
+	bool deltaValid = grid.GetChangesBase() == publishedRevision;
+	bool periodicKeyframe = simulation.GetGeneration() % STREAM_KEYFRAME_INTERVAL == 0;
+	publishedRevision = grid.GetRevision();
+
+	Buffer keyframe;
+	Buffer delta;
+	for(Viewer& viewer : viewers)
+	{
+		if(changed && (!deltaValid || periodicKeyframe))
+		{
+			viewer.needsKeyframe = true;
+		}
+
+		if(!viewer.needsKeyframe && changed)
+		{
+			if(delta == nullptr)
+			{
+				delta = std::make_shared<const std::vector<uint8_t>>(Stream::EncodeDelta(grid, simulation.GetSettings(), simulation.GetGeneration()));
+				stats.deltas++;
+			}
+			if(viewer.queuedBytes + delta->size() <= STREAM_MAX_QUEUED_BYTES)
+			{
+				Enqueue(viewer, delta);
+				continue;
+			}
+			viewer.needsKeyframe = true;
+			stats.skips++;
+		}
+
+		if(viewer.needsKeyframe)
+		{
+			if(keyframe == nullptr)
+			{
+				keyframe = std::make_shared<const std::vector<uint8_t>>(Stream::EncodeKeyframe(grid, simulation.GetSettings(), simulation.GetGeneration()));
+				stats.keyframes++;
+			}
+			//The keyframe replaces everything that was not sent yet
+			DropUnsent(viewer);
+			Enqueue(viewer, keyframe);
+			viewer.needsKeyframe = false;
+		}
+	}
+}
+
+void StreamServer::Flush()
+{
+	for(Viewer& viewer : viewers)
+	{
+		while(!viewer.queue.empty())
+		{
+			const std::vector<uint8_t>& message = *viewer.queue.front();
+			int64_t sent = viewer.socket.Send(message.data() + viewer.sent, message.size() - viewer.sent);
+			if(sent < 0)
+			{
+				viewer.socket.Close();
+				break;
+			}
+			if(sent == 0)
+			{
+				break;
+			}
+			viewer.sent += static_cast<size_t>(sent);
+			viewer.queuedBytes -= static_cast<size_t>(sent);
+			stats.bytesSent += static_cast<uint64_t>(sent);
+			if(viewer.sent == message.size())
+			{
+				viewer.queue.pop_front();
+				viewer.sent = 0;
+			}
+		}
+	}
+	std::erase_if(viewers, [](const Viewer& viewer) { return !viewer.socket.IsOpen(); });
+}
+
+int StreamServer::GetViewerCount() const
+{
+	return static_cast<int>(viewers.size());
+}
+
+bool StreamServer::HasQueued() const
+{
+	return std::any_of(viewers.begin(), viewers.end(), [](const Viewer& viewer) { return !viewer.queue.empty(); });
+}
+
+const StreamServer::Stats& StreamServer::GetStats() const
+{
+	return stats;
+}
+
+const std::string& StreamServer::GetError() const
+{
+	return error;
+}
+
+void StreamServer::Enqueue(Viewer& viewer, const Buffer& message)
+{
+	viewer.queue.push_back(message);
+	viewer.queuedBytes += message->size();
+}
+
+void StreamServer::DropUnsent(Viewer& viewer)
+{
+	//A message that was sent partially has to be completed, otherwise the viewer loses track of the message boundaries
+	size_t keep = viewer.sent > 0 ? 1 : 0;
+	while(viewer.queue.size() > keep)
+	{
+		viewer.queuedBytes -= viewer.queue.back()->size();
+		viewer.queue.pop_back();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include "localsocket.h"
+#include "simulation.h"
+
+//Streams the generations of a simulation to any amount of viewers connected to a local socket
+//Every generation is encoded once and shared by all viewers, up to date viewers get deltas and new viewers a keyframe
+//Sockets never block the simulation: a viewer whose queue grows beyond STREAM_MAX_QUEUED_BYTES loses its unsent messages and continues with a keyframe
+//of the current generation, so slow viewers skip generations instead of slowing down the server or each other
+class StreamServer
+{
+public:
+	struct Stats
+	{
+		uint64_t keyframes = 0;
+		uint64_t deltas = 0;
+		uint64_t bytesSent = 0;
+		//Times a viewer fell behind and its queued messages were replaced by a keyframe
+		uint64_t skips = 0;
+	};
+
+	bool Listen(const std::string& path);
+	//Adds viewers that connected since the last call, they get a keyframe with the next Publish
+	void Accept();
+	//Queues the current generation for all viewers, does nothing for viewers that already have it
+	void Publish(const Simulation& simulation);
+	//Sends as much of the queued messages as the sockets take without blocking, viewers whose connection broke are removed
+	void Flush();
+
+	int GetViewerCount() const;
+	//True if any viewer has messages that were not sent completely
+	bool HasQueued() const;
+	const Stats& GetStats() const;
+	const std::string& GetError() const;
+
+private:
+	using Buffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+	struct Viewer
+	{
+		explicit Viewer(LocalSocket&& socket) : socket(std::move(socket)) {}
+
+		LocalSocket socket;
+		std::deque<Buffer> queue;
+		//Bytes of the first message in the queue that were already sent
+		size_t sent = 0;
+		size_t queuedBytes = 0;
+		bool needsKeyframe = true;
+	};
+
+	LocalSocket listener;
+	std::vector<Viewer> viewers;
+	uint64_t publishedRevision = 0;
+	Stats stats;
+	std::string error;
+
+	static void Enqueue(Viewer& viewer, const Buffer& message);
+	//Drops all messages of the viewer that were not started yet
+	static void DropUnsent(Viewer& viewer);
+};
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "symmetricgrid.h"
+#include <atomic>
+#include <utility>
+
+#include "simulation.h"
+#include "parallel.h"
+
+int SymmetricGrid::Symmetry::GetOrder() const
+{
+	int order = permute ? 6 : 1;
+	for(bool m : mirror)
+	{
+		order *= m ? 2 : 1;
+	}
+	return order;
+}
+
+SymmetricGrid::Symmetry SymmetricGrid::Detect(const Grid3d<IntCell>& grid)
+{
+	const Extent& size = grid.GetSize();
+	const AxisWrap& wrap = grid.GetWrap();
+	auto invariant = [&](auto map)
+	{
+		std::atomic<bool> equal = true;
+		Parallel::For(0, size[2], [&](int z)
+		{
+			for(int y = 0; y < size[1] && equal; y++)
+			{
+				for(int x = 0; x < size[0]; x++)
+				{
+					int p[3] = { x, y, z };
+					map(p);
+					if(static_cast<int>(grid.GetCell(x, y, z)) != static_cast<int>(grid.GetCell(p[0], p[1], p[2])))
+					{
+						equal = false;
+						break;
+					}
+				}
+			}
+		});
+		return equal.load();
+	};
+
+	const Neighbourhood::Info& info = Neighbourhood::Get(grid.GetNeighbourMode());
+	Symmetry symmetry;
+	for(int a = 0; a < 3; a++)
+	{
+		symmetry.mirror[a] = info.mirror[a] && invariant([&](int* p) { p[a] = size[a] - 1 - p[a]; });
+	}
+	//Swapping x, y and y, z generates all permutations, which only map the grid onto itself if the axes are interchangeable
+	bool cubic = size[0] == size[1] && size[1] == size[2] && wrap[0] == wrap[1] && wrap[1] == wrap[2];
+	symmetry.permute = cubic && info.permute && symmetry.mirror[0] && symmetry.mirror[1] && symmetry.mirror[2]
+		&& invariant([](int* p) { std::swap(p[0], p[1]); })
+		&& invariant([](int* p) { std::swap(p[1], p[2]); });
+	return symmetry;
+}
+
+SymmetricGrid::SymmetricGrid(const StaticSimSettings& settings, const Symmetry& symmetry, const Grid3d<IntCell>& grid) : settings(settings), symmetry(symmetry)
+{
+	size = settings.size;
+	for(int a = 0; a < 3; a++)
+	{
+		int half = (size[a] + 1) / 2;
+		extent[a] = symmetry.mirror[a] ? half : size[a];
+		fold[a] = std::vector<int>(size[a] + 2);
+		for(int v = -1; v <= size[a]; v++)
+		{
+			int c = v;
+			if(c < 0 || c >= size[a])
+			{
+				c = settings.wrap[a] ? (c + size[a]) % size[a] : -1;
+			}
+			if(c >= 0 && symmetry.mirror[a] && c >= half)
+			{
+				c = size[a] - 1 - c;
+			}
+			fold[a][v + 1] = c;
+		}
+	}
+
+	maxNeighbours = Neighbourhood::Get(settings.neighbourMode).count;
+	rule = std::vector<uint8_t>(settings.states * (maxNeighbours + 1));
+	for(int state = 0; state < settings.states; state++)
+	{
+		for(int neighbours = 0; neighbours <= maxNeighbours; neighbours++)
+		{
+			rule[(state * (maxNeighbours + 1)) + neighbours] = static_cast<uint8_t>(Simulation::NextState(settings, state, neighbours));
+		}
+	}
+
+	states = std::vector<uint8_t>(extent[0] * extent[1] * extent[2], 0);
+	nextStates = states;
+	for(int z = 0; z < extent[2]; z++)
+	{
+		for(int y = 0; y < extent[1]; y++)
+		{
+			for(int x = 0; x < extent[0]; x++)
+			{
+				//With permutations the domain is the wedge x <= y <= z of the octant
+				if(symmetry.permute && (x > y || y > z))
+				{
+					continue;
+				}
+				int index = (((z * extent[1]) + y) * extent[0]) + x;
+				domain.push_back(index);
+				states[index] = static_cast<uint8_t>(static_cast<int>(grid.GetCell(x, y, z)));
+			}
+		}
+	}
+}
+
+void SymmetricGrid::Step()
+{
+	static const int chunkSize = 4096;
+	int chunks = (static_cast<int>(domain.size()) + chunkSize - 1) / chunkSize;
+	uint8_t alive = static_cast<uint8_t>(settings.states - 1);
+	Neighbourhood::Visit(settings.neighbourMode, [&](auto hood)
+	{
+		using Hood = decltype(hood);
+		Parallel::For(0, chunks, [&](int chunk)
+		{
+			int end = std::min((chunk + 1) * chunkSize, static_cast<int>(domain.size()));
+			for(int d = chunk * chunkSize; d < end; d++)
+			{
+				int index = domain[d];
+				int x = index % extent[0];
+				int y = (index / extent[0]) % extent[1];
+				int z = index / (extent[0] * extent[1]);
+				int count = 0;
+				Hood::ForEach([&](const Neighbourhood::Offset& o)
+				{
+					int nx = fold[0][x + o[0] + 1];
+					int ny = fold[1][y + o[1] + 1];
+					int nz = fold[2][z + o[2] + 1];
+					if(nx >= 0 && ny >= 0 && nz >= 0 && states[Canonical(nx, ny, nz)] == alive)
+					{
+						count++;
+					}
+				});
+				nextStates[index] = rule[(states[index] * (maxNeighbours + 1)) + count];
+			}
+		});
+	});
+	states.swap(nextStates);
+}
+
+void SymmetricGrid::Expand(Grid3d<IntCell>& grid) const
+{
+	IntCell empty = IntCell(0, settings.states - 1);
+	grid.Generate([&](int x, int y, int z)
+	{
+		return empty.WithValue(states[Canonical(fold[0][x + 1], fold[1][y + 1], fold[2][z + 1])]);
+	});
+}
+
+const SymmetricGrid::Symmetry& SymmetricGrid::GetSymmetry() const
+{
+	return symmetry;
+}
+
+int SymmetricGrid::GetDomainSize() const
+{
+	return static_cast<int>(domain.size());
+}
+
+int SymmetricGrid::Canonical(int x, int y, int z) const
+{
+	if(symmetry.permute)
+	{
+		if(x > y)
+		{
+			std::swap(x, y);
+		}
+		if(y > z)
+		{
+			std::swap(y, z);
+		}
+		if(x > y)
+		{
+			std::swap(x, y);
+		}
+	}
+	return (((z * extent[1]) + y) * extent[0]) + x;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "config.h"
+#include "grid3d.h"
+#include "intcell.h"
+
+//Simulation of a grid whose cells are symmetric, which only stores and computes a fundamental domain
+//Cells outside of the domain are mapped into it when counting neighbours, so the domain does not need separate ghost cells
+class SymmetricGrid
+{
+public:
+	struct Symmetry
+	{
+		//Reflection x -> size - 1 - x along each axis
+		bool mirror[3] = { false, false, false };
+		//All permutations of the axes (only together with all reflections, on cubic grids that wrap the same way along all axes)
+		bool permute = false;
+
+		//Amount of symmetric copies of the fundamental domain
+		int GetOrder() const;
+	};
+
+	//Symmetries that map the cells of the grid and its neighbourhood onto themselves, so every step keeps them
+	//Both boundary modes are invariant under all reflections, the neighbourhood may only be invariant under some (see Neighbourhood::Stencil)
+	static Symmetry Detect(const Grid3d<IntCell>& grid);
+
+	SymmetricGrid(const StaticSimSettings& settings, const Symmetry& symmetry, const Grid3d<IntCell>& grid);
+
+	void Step();
+	//Writes all cells to grid in parallel, its neighbours are counted again before its next step
+	void Expand(Grid3d<IntCell>& grid) const;
+
+	const Symmetry& GetSymmetry() const;
+	//Amount of cells that are simulated
+	int GetDomainSize() const;
+
+private:
+	StaticSimSettings settings;
+	Symmetry symmetry;
+	Extent size;
+	int extent[3];
+	int maxNeighbours;
+	//Next state for each (state, neighbours) pair
+	std::vector<uint8_t> rule;
+	//extent[0] * extent[1] * extent[2] cells, only the ones in domain are used
+	std::vector<uint8_t> states;
+	std::vector<uint8_t> nextStates;
+	std::vector<int> domain;
+	//Domain coordinate of the grid coordinate v along each axis at index v + 1 for v in [-1, size], -1 outside of the grid
+	std::vector<int> fold[3];
+
+	//Index of the domain cell that represents the folded coordinates
+	int Canonical(int x, int y, int z) const;
+};
\ No newline at end of file
@@ -1,9 +1,12 @@
 #include "ui.h"
 #include <format>
 #include <type_traits>
-#include <regex>
 #include <cstring>
+#include <chrono>
+#include <cmath>
 #include "magic_enum.hpp"
+#include "rule.h"
+#include "neighbourhood.h"
 
 namespace gui = raylib::gui;
 
@@ -13,23 +16,62 @@ gui::GuiSetStyle(gui::GuiControl::LABEL, gui::GuiControlProperty::TEXT_ALIGNMENT
 gui::GuiSetStyle(gui::GuiControl::LABEL, gui::GuiControlProperty::TEXT_ALIGNMENT, 0);
 
 
-UI::UI(ResetCallback resetCallback, SettingsCallback settingsCallback, StepCallback stepCallback, PlayCallback playCallback) : resetCallback(resetCallback), settingsCallback(settingsCallback), stepCallback(stepCallback), playCallback(playCallback)
+UI::UI(ResetCallback resetCallback, SettingsCallback settingsCallback, StepCallback stepCallback, PlayCallback playCallback, SeekCallback seekCallback)
+	: resetCallback(resetCallback), settingsCallback(settingsCallback), stepCallback(stepCallback), playCallback(playCallback), seekCallback(seekCallback), previews(PREVIEW_CACHE_DIR)
 {
 	gui::LoadDefaultStyle();
 	LoadPreset(START_PRESET);
+	//Computed in the background right away, so they are ready by the time the presets are opened
+	for(const Preset& preset : PRESETS)
+	{
+		previews.Request(preset);
+	}
+	previewTextures = std::vector<raylib::Texture2D>(sizeof(PRESETS) / sizeof(PRESETS[0]), raylib::Texture2D {});
+	presetTexts = std::vector<CachedText<bool>>(sizeof(PRESETS) / sizeof(PRESETS[0]));
+}
+
+UI::~UI()
+{
+	for(raylib::Texture2D& texture : previewTextures)
+	{
+		if(texture.id != 0)
+		{
+			raylib::UnloadTexture(texture);
+		}
+	}
 }
 
 void UI::Update()
 {
+	auto tStart = std::chrono::high_resolution_clock::now();
+	mouseOver = false;
 	RenderFPS();
 	RenderControls();
 	RenderSettings();
 	RenderPresets();
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+	frameCost = frameCost <= 0.0 ? seconds : frameCost * 0.9 + seconds * 0.1;
+}
+
+void UI::SetHistory(int oldest, int newest, int position, size_t bytes)
+{
+	historyOldest = oldest;
+	historyNewest = newest;
+	historyPosition = position;
+	historyBytes = bytes;
+}
+
+bool UI::IsMouseOver() const
+{
+	return mouseOver;
 }
 
 void UI::RenderFPS()
 {
-	gui::GuiLabel(raylib::Rectangle { 0.0f, WINDOW_HEIGHT - UI_LINE_HEIGHT, 50.0f, UI_LINE_HEIGHT }, std::format("FPS = {0}", raylib::GetFPS()).c_str());
+	//The cost of the UI is shown in steps of 0.01 ms, so the text does not change every frame
+	int fps = raylib::GetFPS();
+	int uiCost = static_cast<int>(std::round(frameCost * 100000.0));
+	gui::GuiLabel(raylib::Rectangle { 0.0f, WINDOW_HEIGHT - UI_LINE_HEIGHT, 150.0f, UI_LINE_HEIGHT }, fpsText.Get(std::pair<int, int>(fps, uiCost), [](std::pair<int, int> value) { return std::format("FPS = {0}, UI = {1:.2f} ms", value.first, value.second / 100.0); }));
 }
 
 void UI::RenderControls()
@@ -38,9 +80,11 @@ void UI::RenderControls()
 	std::strcpy(playBtnText, gui::GuiIconText(isPlaying ? gui::ICON_PLAYER_PAUSE : gui::ICON_PLAYER_PLAY, isPlaying ? "PAUSE" : "PLAY"));
 	char stepBtnText[32];
 	std::strcpy(stepBtnText, gui::GuiIconText(gui::ICON_PLAYER_NEXT, "STEP"));
+	char backBtnText[32];
+	std::strcpy(backBtnText, gui::GuiIconText(gui::ICON_PLAYER_PREVIOUS, "BACK"));
 	char resetBtnText[32];
 	std::strcpy(resetBtnText, gui::GuiIconText(gui::ICON_CROSS, "RESET"));
-	const char* btnTexts[3] = { resetBtnText, stepBtnText, playBtnText };
+	const char* btnTexts[4] = { resetBtnText, backBtnText, stepBtnText, playBtnText };
 	float ctrlWidth = 0.0f;
 	for(const char* btnText : btnTexts)
 	{
@@ -53,6 +97,7 @@ void UI::RenderControls()
 	for(const char* btnText : btnTexts)
 	{
 		ctrlRect.width = gui::CalcTextWidth(btnText);
+		BlockMouse(ctrlRect);
 		if(gui::GuiButton(ctrlRect, btnText))
 		{
 			if(btnText == playBtnText)
@@ -63,6 +108,10 @@ void UI::RenderControls()
 			{
 				Step();
 			}
+			else if(btnText == backBtnText)
+			{
+				Seek(historyPosition - 1);
+			}
 			else if(btnText == resetBtnText)
 			{
 				Reset();
@@ -70,6 +119,21 @@ void UI::RenderControls()
 		}
 		ctrlRect.x += ctrlRect.width + UI_CTRL_MARGIN;
 	}
+
+	//History
+	if(historyNewest > historyOldest)
+	{
+		raylib::Rectangle scrubRect = { WINDOW_WIDTH * 0.5f - ctrlWidth * 0.5f, ctrlRect.y + ctrlRect.height + UI_CTRL_MARGIN, ctrlWidth - UI_CTRL_MARGIN, UI_LINE_HEIGHT };
+		BlockMouse(scrubRect);
+		const char* positionText = historyPositionText.Get(historyPosition, [](int position) { return std::format("{0} ", position); });
+		const char* bytesText = historyBytesText.Get(historyBytes, [](size_t bytes) { return std::format(" {:.1f} MB", bytes / (1024.0f * 1024.0f)); });
+		float position = gui::GuiSliderBar(scrubRect, positionText, bytesText, static_cast<float>(historyPosition), static_cast<float>(historyOldest), static_cast<float>(historyNewest));
+		int generation = static_cast<int>(std::roundf(position));
+		if(generation != historyPosition)
+		{
+			Seek(generation);
+		}
+	}
 }
 
 void UI::RenderSettings()
@@ -88,6 +152,7 @@ void UI::RenderSettings()
 		raylib::Rectangle rect = layout.GetNextLayoutRect(UI_CTRL_HEIGHT);
 		rect.x = rect.y * 0.5f;
 		rect.width = rect.height;
+		BlockMouse(rect);
 		if(gui::GuiButton(rect, headerButtonText))
 		{
 			settingsVisible = !settingsVisible;
@@ -108,19 +173,25 @@ void UI::RenderSettings()
 	LABEL_CENTER(gui::GuiLabel(layout.GetNextLayoutRect(), "Rendering"));
 
 	auto [lr, rr] = layout.SplitHorizontal(layout.GetNextLayoutRect(), UI_SETTING_LABEL_RATIO);
-	gui::GuiLabel(lr, "Size");
+	gui::GuiLabel(lr, "Size X/Y/Z");
 	{
-		bool highlight = currStaticSettings.dimSize != data.dimSize;
+		bool highlight = currStaticSettings.size != data.size;
 		staticSettingsMismatch |= highlight;
 		gui::ScopedStyle style(highlight, gui::GuiControl::VALUEBOX, gui::GuiControlProperty::BORDER_COLOR_NORMAL, highlightColor);
-		static bool dimEdit = false;
-		static int tempDimSize = !dimEdit ? data.dimSize : tempDimSize;
-		if(gui::GuiValueBox(rr, "", &tempDimSize, 5, SIM_MAX_DIM_SIZE, dimEdit))
+		static bool sizeEdit[3] = { false, false, false };
+		static int tempSize[3] = { 0, 0, 0 };
+		float boxWidth = rr.width / 3.0f;
+		for(int a = 0; a < 3; a++)
 		{
-			dimEdit = !dimEdit;
-			if(!dimEdit)
+			tempSize[a] = !sizeEdit[a] ? data.size[a] : tempSize[a];
+			if(gui::GuiValueBox(raylib::Rectangle { rr.x + a * boxWidth, rr.y, boxWidth - UI_LINE_MARGIN, rr.height }, "", &tempSize[a], data.wrap[a] ? SIM_MIN_WRAP_DIM_SIZE : 1, SIM_MAX_DIM_SIZE, sizeEdit[a]))
 			{
-				data.dimSize = tempDimSize;
+				sizeEdit[a] = !sizeEdit[a];
+				if(!sizeEdit[a])
+				{
+					data.size[a] = tempSize[a];
+					data.fillDiameter = std::min(data.fillDiameter, static_cast<float>(MinExtent()));
+				}
 			}
 		}
 	}
@@ -172,7 +243,7 @@ void UI::RenderSettings()
 		bool highlight = currStaticSettings.fillDiameter != data.fillDiameter;
 		staticSettingsMismatch |= highlight;
 		gui::ScopedStyle style(highlight, gui::GuiControl::SLIDER, gui::GuiControlProperty::BORDER_COLOR_NORMAL, highlightColor);
-		data.fillDiameter = gui::GuiSliderBar(rr, std::format("{:.0f}", data.fillDiameter).c_str(), "", data.fillDiameter, 1, data.dimSize);
+		data.fillDiameter = gui::GuiSliderBar(rr, fillDiameterText.Get(data.fillDiameter, [](float value) { return std::format("{:.0f}", value); }), "", data.fillDiameter, 1, static_cast<float>(MinExtent()));
 		data.fillDiameter = std::roundf(data.fillDiameter);
 	}
 
@@ -182,7 +253,20 @@ void UI::RenderSettings()
 		bool highlight = currStaticSettings.fillProb != data.fillProb;
 		staticSettingsMismatch |= highlight;
 		gui::ScopedStyle style(highlight, gui::GuiControl::SLIDER, gui::GuiControlProperty::BORDER_COLOR_NORMAL, highlightColor);
-		data.fillProb = gui::GuiSliderBar(rr, std::format("{:.0f}%", data.fillProb * 100.0f).c_str(), "", data.fillProb, 0.0f, 1.0f);
+		data.fillProb = gui::GuiSliderBar(rr, fillProbText.Get(data.fillProb, [](float value) { return std::format("{:.0f}%", value * 100.0f); }), "", data.fillProb, 0.0f, 1.0f);
+	}
+
+	std::tie(lr, rr) = layout.SplitHorizontal(layout.GetNextLayoutRect(), UI_SETTING_LABEL_RATIO);
+	gui::GuiLabel(lr, "Instances");
+	{
+		bool highlight = currStaticSettings.instances != data.instances;
+		staticSettingsMismatch |= highlight;
+		gui::ScopedStyle style(highlight, gui::GuiControl::VALUEBOX, gui::GuiControlProperty::BORDER_COLOR_NORMAL, highlightColor);
+		static bool instancesEditMode = false;
+		if(gui::GuiValueBox(rr, "", &data.instances, 1, SIM_MAX_INSTANCES, instancesEditMode))
+		{
+			instancesEditMode = !instancesEditMode;
+		}
 	}
 
 	//Simulation
@@ -192,22 +276,62 @@ void UI::RenderSettings()
 	std::tie(lr, rr) = layout.SplitHorizontal(layout.GetNextLayoutRect(), UI_SETTING_LABEL_RATIO);
 	gui::GuiLabel(lr, "Wrap Around");
 	{
-		bool highlight = currStaticSettings.wrapSide != data.wrapSide;
+		bool highlight = currStaticSettings.wrap != data.wrap;
 		staticSettingsMismatch |= highlight;
 		gui::ScopedStyle style(highlight, gui::GuiControl::TOGGLE, gui::GuiControlProperty::BORDER_COLOR_NORMAL, highlightColor);
-		data.wrapSide = gui::GuiToggleGroup(raylib::Rectangle { rr.x, rr.y, rr.width * 0.5f, rr.height }, "NO;YES", data.wrapSide ? 1 : 0) == 1;
+		static const char* axisNames[3] = { "X", "Y", "Z" };
+		float toggleWidth = rr.width / 3.0f;
+		for(int a = 0; a < 3; a++)
+		{
+			data.wrap[a] = gui::GuiToggle(raylib::Rectangle { rr.x + a * toggleWidth, rr.y, toggleWidth - UI_LINE_MARGIN, rr.height }, axisNames[a], data.wrap[a]);
+			if(data.wrap[a])
+			{
+				data.size[a] = std::max(data.size[a], SIM_MIN_WRAP_DIM_SIZE);
+			}
+		}
+	}
+
+	std::tie(lr, rr) = layout.SplitHorizontal(layout.GetNextLayoutRect(), UI_SETTING_LABEL_RATIO);
+	gui::GuiLabel(lr, "Update");
+	{
+		bool highlight = currStaticSettings.updateMode != data.updateMode;
+		staticSettingsMismatch |= highlight;
+		gui::ScopedStyle style(highlight, gui::GuiControl::DROPDOWNBOX, gui::GuiControlProperty::BORDER_COLOR_NORMAL, highlightColor);
+		static bool updateModeEdit = false;
+		EnumDropdown(layout, rr, data.updateMode, updateModeEdit);
+	}
+
+	if(data.updateMode == UpdateMode::Asynchronous)
+	{
+		std::tie(lr, rr) = layout.SplitHorizontal(layout.GetNextLayoutRect(), UI_SETTING_LABEL_RATIO);
+		gui::GuiLabel(lr, "Update Prob");
+		bool highlight = currStaticSettings.updateProb != data.updateProb;
+		staticSettingsMismatch |= highlight;
+		gui::ScopedStyle style(highlight, gui::GuiControl::SLIDER, gui::GuiControlProperty::BORDER_COLOR_NORMAL, highlightColor);
+		data.updateProb = gui::GuiSliderBar(rr, updateProbText.Get(data.updateProb, [](float value) { return std::format("{:.0f}%", value * 100.0f); }), "", data.updateProb, 0.01f, 1.0f);
+		data.updateProb = std::roundf(data.updateProb * 100.0f) / 100.0f;
 	}
 
 	std::tie(lr, rr) = layout.SplitHorizontal(layout.GetNextLayoutRect(), UI_SETTING_LABEL_RATIO);
 	gui::GuiLabel(lr, "Steps/s");
 	float oldStepsPerSecond = data.stepsPerSecond;
-	data.stepsPerSecond = gui::GuiSliderBar(rr, std::format("{:.0f}", data.stepsPerSecond).c_str(), "", data.stepsPerSecond, 0.0f, 60.0f);
+	data.stepsPerSecond = gui::GuiSliderBar(rr, stepsPerSecondText.Get(data.stepsPerSecond, [](float value) { return std::format("{:.0f}", value); }), "", data.stepsPerSecond, 0.0f, 60.0f);
 	data.stepsPerSecond = std::roundf(data.stepsPerSecond);
 	if(data.stepsPerSecond != oldStepsPerSecond)
 	{
 		SettingsChanged();
 	}
 
+	std::tie(lr, rr) = layout.SplitHorizontal(layout.GetNextLayoutRect(), UI_SETTING_LABEL_RATIO);
+	gui::GuiLabel(lr, "Brush Radius");
+	float oldBrushRadius = data.brushRadius;
+	data.brushRadius = gui::GuiSliderBar(rr, brushRadiusText.Get(data.brushRadius, [](float value) { return value > 0.0f ? std::format("{:.0f}", value) : std::string("OFF"); }), "", data.brushRadius, 0.0f, BRUSH_MAX_RADIUS);
+	data.brushRadius = std::roundf(data.brushRadius);
+	if(data.brushRadius != oldBrushRadius)
+	{
+		SettingsChanged();
+	}
+
 	//Rules
 	layout.Space(UI_SETTING_SPACE);
 	LABEL_CENTER(gui::GuiLabel(layout.GetNextLayoutRect(), "Rules"));
@@ -237,7 +361,7 @@ void UI::RenderSettings()
 
 	gui::GuiLabel(layout.GetNextLayoutRect(), "Survive Rule");
 	{
-		bool highlight = (uint64_t)currStaticSettings.surviveRule != (uint64_t)ParseRule(std::string(data.surviveRule));
+		bool highlight = (uint64_t)currStaticSettings.surviveRule != (uint64_t)surviveRule.Get(data.surviveRule, data.neighbourMode);
 		staticSettingsMismatch |= highlight;
 		gui::ScopedStyle style(highlight, gui::GuiControl::TEXTBOX, gui::GuiControlProperty::BORDER_COLOR_NORMAL, highlightColor);
 		static bool surviveRuleEdit = false;
@@ -249,7 +373,7 @@ void UI::RenderSettings()
 
 	gui::GuiLabel(layout.GetNextLayoutRect(), "Spawn Rule");
 	{
-		bool highlight = (uint64_t)currStaticSettings.spawnRule != (uint64_t)ParseRule(std::string(data.spawnRule));
+		bool highlight = (uint64_t)currStaticSettings.spawnRule != (uint64_t)spawnRule.Get(data.spawnRule, data.neighbourMode);
 		staticSettingsMismatch |= highlight;
 		gui::ScopedStyle style(highlight, gui::GuiControl::TEXTBOX, gui::GuiControlProperty::BORDER_COLOR_NORMAL, highlightColor);
 		static bool spawnRuleEdit = false;
@@ -265,6 +389,7 @@ void UI::RenderSettings()
 		static const char labelText[] = "Press RESET to apply highlighted settings";
 		gui::GuiLabel(layout.GetNextLayoutRect(), labelText);
 	}
+	BlockMouse(raylib::Rectangle { 0.0f, 0.0f, UI_WIDTH, layout.GetNextLayoutRect().y });
 }
 
 void UI::RenderPresets()
@@ -281,6 +406,7 @@ void UI::RenderPresets()
 		raylib::Rectangle rect = layout.GetNextLayoutRect(UI_CTRL_HEIGHT);
 		rect.width = rect.height;
 		rect.x = WINDOW_WIDTH - rect.width - rect.y * 0.5f;
+		BlockMouse(rect);
 		if(gui::GuiButton(rect, headerButtonText))
 		{
 			presetsVisible = !presetsVisible;
@@ -298,7 +424,7 @@ void UI::RenderPresets()
 	layout.Space(UI_SETTING_SPACE);
 
 	raylib::Rectangle pageCtrlRect = layout.GetNextLayoutRect();
-	static const float pItemHeight = UI_LINE_HEIGHT * 2.5f;
+	static const float pItemHeight = UI_LINE_HEIGHT * 3.0f;
 	static const int itemCount = sizeof(PRESETS) / sizeof(PRESETS[0]);
 	static const float pageHeight = WINDOW_HEIGHT - (pageCtrlRect.y + UI_SETTING_SPACE) * 2.0f;
 	static const int itemsPerPage = static_cast<int>(std::floor(pageHeight / pItemHeight));
@@ -311,7 +437,7 @@ void UI::RenderPresets()
 	{
 		page--;
 	}
-	LABEL_CENTER(gui::GuiLabel(mr, std::format("{0} / {1}", page, pages).c_str()));
+	LABEL_CENTER(gui::GuiLabel(mr, presetPageText.Get(page, [](int page) { return std::format("{0} / {1}", page, pages); })));
 	if(gui::GuiButton(rr, ">"))
 	{
 		page++;
@@ -324,20 +450,40 @@ void UI::RenderPresets()
 	for(int i = from; i < to; i++)
 	{
 		const Preset& preset = PRESETS[i];
+		std::shared_ptr<const PresetPreviews::Preview> preview = previews.Get(preset);
+		if(preview != nullptr && previewTextures[i].id == 0)
+		{
+			previewTextures[i] = raylib::LoadTextureFromImage(raylib::Image { const_cast<raylib::Color*>(preview->pixels.data()), preview->size, preview->size, 1, raylib::PixelFormat::PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 });
+		}
+
 		gui::GuiSetStyle(gui::GuiControl::BUTTON, gui::GuiControlProperty::TEXT_ALIGNMENT, gui::GuiTextAlignment::TEXT_ALIGN_LEFT);
-		std::string content = std::format(" {0}\n {1}/{2}/{3}/{4}", preset.name, preset.surviveRule, preset.spawnRule, preset.states, preset.neighbourMode == NeighbourMode::Moore ? "M" : "VN");
-		if(gui::GuiButton(layout.GetNextLayoutRect(pItemHeight), content.c_str()))
+		const char* content = presetTexts[i].Get(preview != nullptr, [&](bool ready)
+		{
+			std::string stats = ready ? std::format("{0} cells, {1} clusters", preview->cells, preview->clusters) : std::string("...");
+			return std::format(" {0}\n {1}/{2}/{3}/{4}\n {5}", preset.name, preset.surviveRule, preset.spawnRule, preset.states, Neighbourhood::Get(preset.neighbourMode).label, stats);
+		});
+		raylib::Rectangle itemRect = layout.GetNextLayoutRect(pItemHeight);
+		if(gui::GuiButton(itemRect, content))
 		{
 			LoadPreset(preset);
 		}
 		gui::GuiSetStyle(gui::GuiControl::BUTTON, gui::GuiControlProperty::TEXT_ALIGNMENT, gui::GuiTextAlignment::TEXT_ALIGN_CENTER);
+
+		//Thumbnail on the right side of the button, once the preview is ready
+		if(previewTextures[i].id != 0)
+		{
+			float thumbSize = itemRect.height - UI_CTRL_MARGIN * 2.0f;
+			raylib::Rectangle thumbRect = { itemRect.x + itemRect.width - thumbSize - UI_CTRL_MARGIN, itemRect.y + UI_CTRL_MARGIN, thumbSize, thumbSize };
+			raylib::DrawTexturePro(previewTextures[i], raylib::Rectangle { 0.0f, 0.0f, static_cast<float>(previewTextures[i].width), static_cast<float>(previewTextures[i].height) }, thumbRect, raylib::Vector2 { 0.0f, 0.0f }, 0.0f, raylib::WHITE);
+		}
 	}
+	BlockMouse(raylib::Rectangle { WINDOW_WIDTH - UI_WIDTH, 0.0f, UI_WIDTH, layout.GetNextLayoutRect().y });
 }
 
 void UI::LoadPreset(Preset preset)
 {
 	data.fillShape = preset.fillShape;
-	data.fillDiameter = std::clamp(preset.fillDiameter, 0, data.dimSize);
+	data.fillDiameter = std::clamp(preset.fillDiameter, 0, MinExtent());
 	data.fillProb = preset.fillProb;
 	data.neighbourMode = preset.neighbourMode;
 	data.states = preset.states;
@@ -363,6 +509,18 @@ void UI::Step()
 	}
 }
 
+void UI::Seek(int generation)
+{
+	if(isPlaying)
+	{
+		TogglePlay();
+	}
+	if(seekCallback && generation >= historyOldest && generation <= historyNewest)
+	{
+		seekCallback(generation);
+	}
+}
+
 void UI::SettingsChanged()
 {
 	if(settingsCallback)
@@ -372,7 +530,8 @@ void UI::SettingsChanged()
 			.renderMode = data.renderMode,
 			.colorMode = data.colorMode,
 			.gradientPreset = data.gradientPreset,
-			.stepsPerSecond = data.stepsPerSecond
+			.stepsPerSecond = data.stepsPerSecond,
+			.brushRadius = data.brushRadius
 		});
 	}
 }
@@ -385,53 +544,58 @@ void UI::Reset()
 	{
 		currStaticSettings = StaticSimSettings
 		{
-			.dimSize = data.dimSize,
+			.size = data.size,
 			.fillShape = data.fillShape,
 			.fillDiameter = data.fillDiameter,
 			.fillProb = data.fillProb,
-			.wrapSide = data.wrapSide,
+			.wrap = data.wrap,
 			.neighbourMode = data.neighbourMode,
 			.states = data.states,
-			.surviveRule = ParseRule(std::string(data.surviveRule)),
-			.spawnRule = ParseRule(std::string(data.spawnRule)),
+			.surviveRule = surviveRule.Get(data.surviveRule, data.neighbourMode),
+			.spawnRule = spawnRule.Get(data.spawnRule, data.neighbourMode),
+			.instances = data.instances,
+			.updateMode = data.updateMode,
+			.updateProb = data.updateProb
 		};
 		resetCallback(currStaticSettings);
 	}
 }
 
-BitMask UI::ParseRule(std::string rule)
+void UI::BlockMouse(raylib::Rectangle rect)
+{
+	mouseOver |= raylib::CheckCollisionPointRec(raylib::GetMousePosition(), rect);
+}
+
+int UI::MinExtent() const
 {
-	rule = std::regex_replace(rule, std::regex(" "), "");
-	BitMask mask;
-	const std::regex reg(R"(((\d+)-(\d+))|(\d+))");
-	std::smatch match;
-	while(std::regex_search(rule, match, reg))
+	return std::min({ data.size[0], data.size[1], data.size[2] });
+}
+
+template<typename T>
+const std::string& UI::EnumOptions()
+{
+	static const std::string options = []()
 	{
-		if(match[1].str().length())
+		std::string options = "";
+		for(T n : magic_enum::enum_values<T>())
 		{
-			//Range
-			int from = std::stoi(match[2]);
-			int to = std::stoi(match[3]);
-			for(int i = from; i <= to; i++)
+			if(options.length() > 0)
 			{
-				if(i >= 0 && i <= 26)
-				{
-					mask.Set(i, true);
-				}
+				options.append(";");
 			}
-		}
-		else
-		{
-			//Single int
-			int i = std::stoi(match[0]);
-			if(i >= 0 && i <= 26)
+			//Neighbourhoods are listed by the name in their definition
+			if constexpr(std::is_same<T, NeighbourMode>::value)
+			{
+				options.append(Neighbourhood::Get(n).name);
+			}
+			else
 			{
-				mask.Set(i, true);
+				options.append(magic_enum::enum_name(n));
 			}
 		}
-		rule = match.suffix();
-	}
-	return mask;
+		return options;
+	}();
+	return options;
 }
 
 template<typename T>
@@ -439,17 +603,7 @@ bool UI::EnumDropdown(gui::layout::VerticalLayout& layout, raylib::Rectangle rec
 {
 	static_assert(std::is_enum<T>::value, "Must be an enum type");
 
-	auto enumValues = magic_enum::enum_values<T>();
-	std::string options = "";
-	std::for_each(enumValues.begin(), enumValues.end(), [&](T n)
-	{
-		if(options.length() > 0)
-		{
-			options.append(";");
-		}
-		options.append(magic_enum::enum_name(n));
-	});
-
+	const std::string& options = EnumOptions<T>();
 	int val = static_cast<int>(value);
 	int prevVal = val;
 	if(gui::GuiDropdownBox(rect, options.c_str(), &val, editMode))
@@ -459,7 +613,7 @@ bool UI::EnumDropdown(gui::layout::VerticalLayout& layout, raylib::Rectangle rec
 
 	if(editMode)
 	{
-		layout.Space(enumValues.size() * (UI_LINE_HEIGHT + UI_LINE_MARGIN));
+		layout.Space(magic_enum::enum_count<T>() * (UI_LINE_HEIGHT + UI_LINE_MARGIN));
 	}
 
 	value = static_cast<T>(val);
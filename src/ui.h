@@ -1,6 +1,12 @@
 #pragma once
+#include <string>
+#include <vector>
+#include <utility>
+
 #include "config.h"
+#include "rule.h"
 #include "presets.h"
+#include "presetpreviews.h"
 #define RAYGUI_STATIC
 #include "raylibinclude.h"
 
@@ -11,13 +17,19 @@ public:
 	typedef void (*SettingsCallback)(DynamicSimSettings);
 	typedef void (*StepCallback)();
 	typedef void (*PlayCallback)(bool);
-	UI(ResetCallback resetCallback, SettingsCallback settingsCallback, StepCallback stepCallback, PlayCallback playCallback);
+	typedef void (*SeekCallback)(int);
+	UI(ResetCallback resetCallback, SettingsCallback settingsCallback, StepCallback stepCallback, PlayCallback playCallback, SeekCallback seekCallback);
+	~UI();
 	void Update();
+	//Range of generations that can be restored with the step back button and the scrub slider, bytes is the memory used by the history
+	void SetHistory(int oldest, int newest, int position, size_t bytes);
+	//True if the mouse was over any UI element in the last Update
+	bool IsMouseOver() const;
 
 private:
 	struct UIData
 	{
-		int dimSize = 50;
+		Extent size = { 50, 50, 50 };
 		RenderMode renderMode = RenderMode::Quad;
 		ColorMode colorMode = ColorMode::Radius;
 		GradientPreset gradientPreset = GradientPreset::Random_3;
@@ -25,9 +37,13 @@ private:
 		FillShape fillShape = FillShape::Cube;
 		float fillDiameter = 5;
 		float fillProb = 0.25f;
+		int instances = 1;
 
-		bool wrapSide = true;
+		AxisWrap wrap = { true, true, true };
+		UpdateMode updateMode = UpdateMode::Synchronous;
+		float updateProb = 0.5f;
 		float stepsPerSecond = 30.0f;
+		float brushRadius = 0.0f;
 
 		NeighbourMode neighbourMode = NeighbourMode::Moore;
 		int states = 2;
@@ -35,13 +51,79 @@ private:
 		char spawnRule[128] = "";
 	};
 
+	//Text that is only formatted again when the value it shows changes
+	template<typename V>
+	struct CachedText
+	{
+		V value = {};
+		bool valid = false;
+		std::string text;
+
+		template<typename F>
+		const char* Get(V newValue, F format)
+		{
+			if(!valid || newValue != value)
+			{
+				value = newValue;
+				text = format(newValue);
+				valid = true;
+			}
+			return text.c_str();
+		}
+	};
+
+	//Mask of the text in a rule text box, only parsed again when the text or the neighbourhood changes
+	struct CachedRule
+	{
+		std::string text;
+		NeighbourMode neighbourMode = NeighbourMode::Moore;
+		BitMask mask;
+		bool valid = false;
+
+		const BitMask& Get(const char* newText, NeighbourMode newNeighbourMode)
+		{
+			if(!valid || text != newText || neighbourMode != newNeighbourMode)
+			{
+				text = newText;
+				neighbourMode = newNeighbourMode;
+				mask = Rule::Parse(text, neighbourMode);
+				valid = true;
+			}
+			return mask;
+		}
+	};
+
 	ResetCallback resetCallback;
 	SettingsCallback settingsCallback;
 	StepCallback stepCallback;
 	PlayCallback playCallback;
+	SeekCallback seekCallback;
 	UIData data;
 	StaticSimSettings currStaticSettings;
 	bool isPlaying = false;
+	bool mouseOver = false;
+	int historyOldest = 0;
+	int historyNewest = 0;
+	int historyPosition = 0;
+	size_t historyBytes = 0;
+	PresetPreviews previews;
+	//Thumbnail of each preset in PRESETS, id 0 until its preview is ready
+	std::vector<raylib::Texture2D> previewTextures;
+	//Button text of each preset in PRESETS, built again once its preview is ready
+	std::vector<CachedText<bool>> presetTexts;
+	CachedText<int> presetPageText;
+	CachedRule surviveRule;
+	CachedRule spawnRule;
+	//Frames per second and the time that Update takes in 0.01 ms, averaged over a few frames
+	CachedText<std::pair<int, int>> fpsText;
+	CachedText<float> fillDiameterText;
+	CachedText<float> fillProbText;
+	CachedText<float> updateProbText;
+	CachedText<float> stepsPerSecondText;
+	CachedText<float> brushRadiusText;
+	CachedText<int> historyPositionText;
+	CachedText<size_t> historyBytesText;
+	double frameCost = 0.0;
 
 	void RenderFPS();
 	void RenderControls();
@@ -50,11 +132,16 @@ private:
 	void LoadPreset(Preset preset);
 	void TogglePlay();
 	void Step();
+	void Seek(int generation);
 	void SettingsChanged();
 	void Reset();
+	void BlockMouse(raylib::Rectangle rect);
+	//Smallest size of the grid along any axis, the largest fill diameter that fits
+	int MinExtent() const;
 
-	BitMask ParseRule(std::string rule);
-
+	//Options of a dropdown for all values of the enum (separated by ';'), built once per enum
+	template<typename T>
+	static const std::string& EnumOptions();
 	template<typename T>
 	bool EnumDropdown(raylib::gui::layout::VerticalLayout& layout, raylib::Rectangle rect, T& value, bool& editMode);
 };
\ No newline at end of file